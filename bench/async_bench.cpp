@@ -0,0 +1,80 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#include "harness.hpp"
+
+#include <atomic>
+#include <maybe/cancel_token.hpp>
+#include <maybe/executor.hpp>
+#include <thread>
+
+using maybe::cancel_token;
+using maybe::result;
+
+namespace bench {
+    void register_async(registry& r)
+    {
+        r.add("cancel_token_check", {{"token", "live"}}, [](std::uint64_t n) {
+            cancel_token token;
+            unsigned cancelled = 0;
+            for (std::uint64_t i = 0; i < n; ++i) {
+                cancelled += token.is_cancelled();
+            }
+            do_not_optimize(cancelled);
+        });
+
+        r.add("cancel_token_check", {{"token", "deadline"}}, [](std::uint64_t n) {
+            auto token = cancel_token::with_timeout(std::chrono::hours(1));
+            unsigned cancelled = 0;
+            for (std::uint64_t i = 0; i < n; ++i) {
+                cancelled += token.is_cancelled();
+            }
+            do_not_optimize(cancelled);
+        });
+
+        r.add("and_then", {{"token", "none"}}, [](std::uint64_t n) {
+            for (std::uint64_t i = 0; i < n; ++i) {
+                auto out = result<int, int>::ok(static_cast<int>(i)).and_then(
+                    [](int v) { return result<int, int>::ok(v + 1); });
+                do_not_optimize(out);
+            }
+        });
+
+        r.add("and_then", {{"token", "live"}}, [](std::uint64_t n) {
+            cancel_token token;
+            for (std::uint64_t i = 0; i < n; ++i) {
+                auto out = result<int, int>::ok(static_cast<int>(i)).and_then(
+                    token, [](int v) { return result<int, int>::ok(v + 1); });
+                do_not_optimize(out);
+            }
+        });
+
+        r.add("executor_submit_get", {{"threads", "1"}}, [](std::uint64_t n) {
+            static maybe::executor executor(1);
+            for (std::uint64_t i = 0; i < n; ++i) {
+                auto out = executor
+                               .submit([i]() { return result<int, int>::ok(static_cast<int>(i)); })
+                               .get();
+                do_not_optimize(out);
+            }
+        });
+
+        r.add("executor_execute", {{"threads", "2"}}, [](std::uint64_t n) {
+            static maybe::executor executor(2);
+            std::atomic<std::uint64_t> done{0};
+            for (std::uint64_t i = 0; i < n; ++i) {
+                executor.execute([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+            }
+            while (done.load(std::memory_order_acquire) != n) {
+                std::this_thread::yield();
+            }
+        });
+    }
+}
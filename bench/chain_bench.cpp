@@ -0,0 +1,88 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#include "harness.hpp"
+
+#include <maybe/result.hpp>
+#include <string>
+
+using maybe::result;
+
+namespace bench {
+    namespace {
+        template <int Depth>
+        struct map_chain final {
+            static result<int, int> apply(result<int, int> r)
+            {
+                return map_chain<Depth - 1>::apply(r.map([](int v) { return v + 1; }));
+            }
+        };
+
+        template <>
+        struct map_chain<0> final {
+            static result<int, int> apply(result<int, int> r)
+            {
+                return r;
+            }
+        };
+
+        template <int Depth>
+        struct and_then_chain final {
+            static result<int, int> apply(result<int, int> r)
+            {
+                return and_then_chain<Depth - 1>::apply(
+                    r.and_then([](int v) { return result<int, int>::ok(v + 1); }));
+            }
+        };
+
+        template <>
+        struct and_then_chain<0> final {
+            static result<int, int> apply(result<int, int> r)
+            {
+                return r;
+            }
+        };
+
+        template <typename Chain>
+        void add_chain(registry& r, const char* name, int depth)
+        {
+            for (auto input : {"ok", "err"}) {
+                auto ok = std::string(input) == "ok";
+                r.add(name, {{"depth", std::to_string(depth)}, {"input", input}},
+                      [ok](std::uint64_t n) {
+                          for (std::uint64_t i = 0; i < n; ++i) {
+                              auto start = ok ? result<int, int>::ok(static_cast<int>(i))
+                                              : result<int, int>::err(static_cast<int>(i));
+                              do_not_optimize(start);
+                              auto out = Chain::apply(start);
+                              do_not_optimize(out);
+                          }
+                      });
+            }
+        }
+    }
+
+    void register_chains(registry& r)
+    {
+        add_chain<map_chain<1>>(r, "map_chain", 1);
+        add_chain<map_chain<2>>(r, "map_chain", 2);
+        add_chain<map_chain<4>>(r, "map_chain", 4);
+        add_chain<map_chain<8>>(r, "map_chain", 8);
+        add_chain<map_chain<16>>(r, "map_chain", 16);
+        add_chain<map_chain<32>>(r, "map_chain", 32);
+
+        add_chain<and_then_chain<1>>(r, "and_then_chain", 1);
+        add_chain<and_then_chain<2>>(r, "and_then_chain", 2);
+        add_chain<and_then_chain<4>>(r, "and_then_chain", 4);
+        add_chain<and_then_chain<8>>(r, "and_then_chain", 8);
+        add_chain<and_then_chain<16>>(r, "and_then_chain", 16);
+        add_chain<and_then_chain<32>>(r, "and_then_chain", 32);
+    }
+}
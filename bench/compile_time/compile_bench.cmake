@@ -0,0 +1,175 @@
+#
+# Copyright 2016 TRAFI
+#
+# Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+# http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+# http://opensource.org/licenses/MIT>, at your option. This file may not be
+# copied, modified, or distributed except according to those terms.
+#
+
+# Compile-time benchmark. Generates translation units with `types` independent chains of
+# `depth` calls alternating between map and and_then, so that every call instantiates a new
+# result<R, E>, and records how long they take to compile. Run with cmake -P and:
+#
+#   COMPILER     C++ compiler
+#   INCLUDES     ;-separated include directories
+#   WORK_DIR     directory for the generated sources and compiler output
+#   OUTPUT       JSON file to write
+#   TYPES        ;-separated chain counts, default 10;50
+#   DEPTHS       ;-separated chain depths, default 8;32
+#   REPETITIONS  compilations per unit, the fastest is recorded, default 3
+#   BASELINE     optional JSON file written by an earlier run to compare against
+#
+# GCC reports allocated memory and template instantiation time with -ftime-report. Clang writes a
+# -ftime-trace file per unit next to the generated source, which can be opened in
+# chrome://tracing or speedscope.
+
+foreach(var COMPILER WORK_DIR OUTPUT)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "${var} is not set")
+    endif()
+endforeach()
+if(NOT DEFINED TYPES)
+    set(TYPES 10 50)
+endif()
+if(NOT DEFINED DEPTHS)
+    set(DEPTHS 8 32)
+endif()
+if(NOT DEFINED REPETITIONS)
+    set(REPETITIONS 3)
+endif()
+
+set(include_flags "")
+foreach(dir ${INCLUDES})
+    if(dir)
+        list(APPEND include_flags "-I${dir}")
+    endif()
+endforeach()
+
+execute_process(COMMAND ${COMPILER} --version OUTPUT_VARIABLE version)
+string(REGEX REPLACE "\n.*" "" version "${version}")
+if(version MATCHES "clang")
+    set(report_flag -ftime-trace)
+else()
+    set(report_flag -ftime-report)
+endif()
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+function(generate_unit path types depth)
+    set(source "#include <maybe/result.hpp>\n\ntemplate <int I, int J>\nstruct tag final {\n    int v;\n};\n")
+    math(EXPR last_type "${types} - 1")
+    foreach(i RANGE ${last_type})
+        string(APPEND source "\nint chain_${i}(int x)\n{\n")
+        string(APPEND source "    return maybe::result<tag<${i}, 0>, int>::ok(tag<${i}, 0>{x})\n")
+        foreach(j RANGE 1 ${depth})
+            math(EXPR from "${j} - 1")
+            math(EXPR odd "${j} % 2")
+            if(odd)
+                string(APPEND source "        .map([](tag<${i}, ${from}> t) { return tag<${i}, ${j}>{t.v + 1}; })\n")
+            else()
+                string(APPEND source "        .and_then([](tag<${i}, ${from}> t) { return maybe::result<tag<${i}, ${j}>, int>::ok(tag<${i}, ${j}>{t.v}); })\n")
+            endif()
+        endforeach()
+        string(APPEND source "        .ok_value_or(tag<${i}, ${depth}>{0})\n        .v;\n}\n")
+    endforeach()
+    file(WRITE ${path} "${source}")
+endfunction()
+
+# Microseconds since the epoch. CMake before 3.23 has no sub-second timestamps.
+function(now_us out)
+    if(CMAKE_VERSION VERSION_LESS 3.23)
+        string(TIMESTAMP seconds "%s" UTC)
+        set(${out} "${seconds}000000" PARENT_SCOPE)
+    else()
+        string(TIMESTAMP stamp "%s%f" UTC)
+        set(${out} ${stamp} PARENT_SCOPE)
+    endif()
+endfunction()
+
+# Parses a -ftime-report line such as " TOTAL   :   0.30   0.16   0.47   29M" into wall
+# milliseconds and kilobytes.
+function(parse_report report phase out_ms out_kb)
+    set(${out_ms} "null" PARENT_SCOPE)
+    set(${out_kb} "null" PARENT_SCOPE)
+    string(REGEX MATCH " ${phase} +:[^\n]*" line "${report}")
+    if(NOT line)
+        return()
+    endif()
+    string(REGEX MATCHALL "[0-9]+\\.[0-9]+ " times "${line}")
+    list(LENGTH times count)
+    if(count GREATER 0)
+        math(EXPR wall_index "${count} - 1")
+        list(GET times ${wall_index} wall)
+        string(STRIP "${wall}" wall)
+        string(REPLACE "." "" wall "${wall}")
+        math(EXPR wall "${wall} * 10")
+        set(${out_ms} ${wall} PARENT_SCOPE)
+    endif()
+    if(line MATCHES "([0-9]+)([kMG]) *(\\(|$)")
+        set(kb ${CMAKE_MATCH_1})
+        if(CMAKE_MATCH_2 STREQUAL "M")
+            math(EXPR kb "${kb} * 1024")
+        elseif(CMAKE_MATCH_2 STREQUAL "G")
+            math(EXPR kb "${kb} * 1024 * 1024")
+        endif()
+        set(${out_kb} ${kb} PARENT_SCOPE)
+    endif()
+endfunction()
+
+if(DEFINED BASELINE AND EXISTS "${BASELINE}")
+    file(READ ${BASELINE} baseline)
+endif()
+
+set(entries "")
+foreach(types IN LISTS TYPES)
+    foreach(depth IN LISTS DEPTHS)
+        set(name "chains_${types}_depth_${depth}")
+        set(source ${WORK_DIR}/${name}.cpp)
+        generate_unit(${source} ${types} ${depth})
+
+        set(best "")
+        foreach(repetition RANGE 1 ${REPETITIONS})
+            now_us(start)
+            execute_process(
+                    COMMAND ${COMPILER} -std=c++14 -O0 -c ${report_flag} ${include_flags}
+                            ${source} -o ${WORK_DIR}/${name}.o
+                    WORKING_DIRECTORY ${WORK_DIR}
+                    RESULT_VARIABLE status
+                    ERROR_VARIABLE report)
+            now_us(end)
+            if(NOT status EQUAL 0)
+                message(FATAL_ERROR "compiling ${source} failed:\n${report}")
+            endif()
+            math(EXPR elapsed "(${end} - ${start}) / 1000")
+            if(best STREQUAL "" OR elapsed LESS best)
+                set(best ${elapsed})
+                set(best_report "${report}")
+            endif()
+        endforeach()
+
+        parse_report("${best_report}" "TOTAL" total_ms allocated_kb)
+        parse_report("${best_report}" "template instantiation" instantiation_ms instantiation_kb)
+        math(EXPR results "${types} * (${depth} + 1)")
+
+        set(change "")
+        if(baseline MATCHES "\"${name}\"[^}]*\"wall_ms\": ([0-9]+)")
+            math(EXPR percent "(${best} - ${CMAKE_MATCH_1}) * 100 / ${CMAKE_MATCH_1}")
+            set(change " (${percent}% vs baseline)")
+        endif()
+        message(STATUS "${name}: ${best} ms, ${allocated_kb} kB${change}")
+
+        if(entries)
+            string(APPEND entries ",")
+        endif()
+        string(APPEND entries "\n    {\"name\": \"${name}\", \"chains\": ${types}, \"depth\": ${depth}, "
+                              "\"result_types\": ${results}, \"wall_ms\": ${best}, "
+                              "\"report_total_ms\": ${total_ms}, \"allocated_kb\": ${allocated_kb}, "
+                              "\"instantiation_ms\": ${instantiation_ms}, "
+                              "\"instantiation_kb\": ${instantiation_kb}}")
+    endforeach()
+endforeach()
+
+string(TIMESTAMP date "%Y-%m-%dT%H:%M:%SZ" UTC)
+file(WRITE ${OUTPUT} "{\n  \"context\": {\n    \"compiler\": \"${version}\",\n    \"date\": \"${date}\"\n  },\n  \"units\": [${entries}\n  ]\n}\n")
+message(STATUS "wrote ${OUTPUT}")
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#include "harness.hpp"
+
+#include <maybe/result.hpp>
+#include <string>
+
+using maybe::result;
+
+namespace bench {
+    void register_construction(registry& r)
+    {
+        r.add("construct", {{"kind", "ok"}, {"type", "int"}}, [](std::uint64_t n) {
+            for (std::uint64_t i = 0; i < n; ++i) {
+                auto value = result<int, int>::ok(static_cast<int>(i));
+                do_not_optimize(value);
+            }
+        });
+
+        r.add("construct", {{"kind", "err"}, {"type", "int"}}, [](std::uint64_t n) {
+            for (std::uint64_t i = 0; i < n; ++i) {
+                auto value = result<int, int>::err(static_cast<int>(i));
+                do_not_optimize(value);
+            }
+        });
+
+        r.add("construct", {{"kind", "ok"}, {"type", "void"}}, [](std::uint64_t n) {
+            for (std::uint64_t i = 0; i < n; ++i) {
+                auto value = result<void, int>::ok();
+                do_not_optimize(value);
+            }
+        });
+
+        r.add("construct", {{"kind", "ok"}, {"type", "string"}}, [](std::uint64_t n) {
+            std::string text = "short";
+            for (std::uint64_t i = 0; i < n; ++i) {
+                auto value = result<std::string, int>::ok(text);
+                do_not_optimize(value);
+            }
+        });
+
+        r.add("construct", {{"kind", "err"}, {"type", "string"}}, [](std::uint64_t n) {
+            std::string text = "short";
+            for (std::uint64_t i = 0; i < n; ++i) {
+                auto value = result<int, std::string>::err(text);
+                do_not_optimize(value);
+            }
+        });
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#include "frames.hpp"
+#include "harness.hpp"
+
+#include <maybe/result.hpp>
+#include <string>
+
+using maybe::result;
+
+// Error propagation on 1 to 64 threads at once. The result path touches no shared state, so its
+// ns_per_op should stay flat as threads are added, up to the number of cores. Unwinding may take
+// process-wide locks in the runtime, which shows up as ns_per_op growing with the thread count.
+namespace bench {
+    namespace {
+        const int depth = 8;
+    }
+
+    void register_contention(registry& r)
+    {
+        for (auto percent : {0u, 10u, 50u}) {
+            auto pattern = failure_pattern(percent);
+            auto mask = pattern.size() - 1;
+
+            for (auto threads : {1u, 2u, 4u, 8u, 16u, 32u, 64u}) {
+                params p{{"depth", std::to_string(depth)}, {"error_rate", std::to_string(percent)}};
+
+                r.add_threaded(
+                    "contended_result", p, threads, [pattern, mask](unsigned t, std::uint64_t n) {
+                        int sum = 0;
+                        auto offset = t * 997;
+                        for (std::uint64_t i = 0; i < n; ++i) {
+                            auto out = result_frames<depth>::call(static_cast<int>(i),
+                                                                   pattern[(i + offset) & mask]);
+                            sum += out.is_ok() ? out.ok_value() : out.err_value();
+                        }
+                        do_not_optimize(sum);
+                    });
+
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+                r.add_threaded(
+                    "contended_exception", p, threads, [pattern, mask](unsigned t, std::uint64_t n) {
+                        int sum = 0;
+                        auto offset = t * 997;
+                        for (std::uint64_t i = 0; i < n; ++i) {
+                            try {
+                                sum += throw_frames<depth>::call(static_cast<int>(i),
+                                                                 pattern[(i + offset) & mask]);
+                            } catch (const frame_error& e) {
+                                sum += e.code;
+                            }
+                        }
+                        do_not_optimize(sum);
+                    });
+#endif
+            }
+        }
+    }
+}
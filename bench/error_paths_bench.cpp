@@ -0,0 +1,86 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#include "harness.hpp"
+
+#include <cstdint>
+#include <maybe/result.hpp>
+#include <string>
+#include <vector>
+
+using maybe::result;
+
+// A map/and_then chain over inputs of which a given percentage fails at the start, so that the
+// err value is passed through every step. bench/CMakeLists.txt compiles this file three times:
+// as is, with MAYBE_RESULT_HOT_ERRORS and with MAYBE_RESULT_COLD_ERRORS. The chain only calls
+// lambdas local to this file, so the builds share no combinator definitions.
+#if defined(MAYBE_RESULT_HOT_ERRORS)
+#define ERROR_PATHS_MODE "hot"
+#define ERROR_PATHS_REGISTER register_error_paths_hot
+#elif defined(MAYBE_RESULT_COLD_ERRORS)
+#define ERROR_PATHS_MODE "cold"
+#define ERROR_PATHS_REGISTER register_error_paths_cold
+#else
+#define ERROR_PATHS_MODE "unlikely"
+#define ERROR_PATHS_REGISTER register_error_paths
+#endif
+
+namespace bench {
+    namespace {
+        typedef result<int, std::string> string_result;
+
+        const std::size_t input_count = 4096;
+
+        /**
+         * Inputs where `error_percent` of the values are negative. Failures are spread by a fixed
+         * linear congruential generator, so that the branch predictor can not learn them.
+         */
+        std::vector<int> make_inputs(unsigned error_percent)
+        {
+            std::vector<int> inputs(input_count);
+            std::uint32_t state = 12345;
+            for (std::size_t i = 0; i < input_count; ++i) {
+                state = state * 1664525u + 1013904223u;
+                inputs[i] = (state >> 8) % 100 < error_percent ? -1 : static_cast<int>(i);
+            }
+            return inputs;
+        }
+
+        BENCH_NOINLINE string_result chain(int x)
+        {
+            auto start = x < 0 ? string_result::err(std::string("negative input"))
+                               : string_result::ok(x);
+            return std::move(start)
+                .map([](int v) { return v + 1; })
+                .and_then([](int v) { return string_result::ok(v * 3); })
+                .map([](int v) { return v ^ 0x55; })
+                .and_then([](int v) { return string_result::ok(v - 7); })
+                .map([](int v) { return v * 5; })
+                .and_then([](int v) { return string_result::ok(v + 11); })
+                .map([](int v) { return v >> 1; })
+                .and_then([](int v) { return string_result::ok(v | 1); });
+        }
+    }
+
+    void ERROR_PATHS_REGISTER(registry& r)
+    {
+        for (unsigned error_percent : {0u, 1u, 50u}) {
+            auto inputs = make_inputs(error_percent);
+            r.add("error_paths",
+                  {{"errors", ERROR_PATHS_MODE}, {"error_rate", std::to_string(error_percent)}},
+                  [inputs](std::uint64_t n) {
+                      for (std::uint64_t i = 0; i < n; ++i) {
+                          auto out = chain(inputs[i % input_count]);
+                          do_not_optimize(out);
+                      }
+                  });
+        }
+    }
+}
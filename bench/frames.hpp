@@ -0,0 +1,88 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include "harness.hpp"
+
+#include <maybe/result.hpp>
+
+// Call stacks of `Depth` non-inlined frames, one per error propagation strategy. Each frame
+// forwards a failure and adds one to the value on success, so that the frames can not be folded
+// into one.
+namespace bench {
+    struct frame_error final {
+        int code;
+    };
+
+    template <int Depth>
+    struct result_frames final {
+        BENCH_NOINLINE static maybe::result<int, int> call(int x, bool fail)
+        {
+            auto r = result_frames<Depth - 1>::call(x, fail);
+            if (r.is_err()) {
+                return maybe::result<int, int>::err(r.err_value());
+            }
+            return maybe::result<int, int>::ok(r.ok_value() + 1);
+        }
+    };
+
+    template <>
+    struct result_frames<0> final {
+        BENCH_NOINLINE static maybe::result<int, int> call(int x, bool fail)
+        {
+            return fail ? maybe::result<int, int>::err(x) : maybe::result<int, int>::ok(x);
+        }
+    };
+
+    template <int Depth>
+    struct code_frames final {
+        BENCH_NOINLINE static int call(int x, bool fail, int& out)
+        {
+            int value;
+            if (auto code = code_frames<Depth - 1>::call(x, fail, value)) {
+                return code;
+            }
+            out = value + 1;
+            return 0;
+        }
+    };
+
+    template <>
+    struct code_frames<0> final {
+        BENCH_NOINLINE static int call(int x, bool fail, int& out)
+        {
+            if (fail) {
+                return x | 1;
+            }
+            out = x;
+            return 0;
+        }
+    };
+
+    template <int Depth>
+    struct throw_frames final {
+        BENCH_NOINLINE static int call(int x, bool fail)
+        {
+            return throw_frames<Depth - 1>::call(x, fail) + 1;
+        }
+    };
+
+    template <>
+    struct throw_frames<0> final {
+        BENCH_NOINLINE static int call(int x, bool fail)
+        {
+            if (fail) {
+                throw frame_error{x};
+            }
+            return x;
+        }
+    };
+}
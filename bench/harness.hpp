@@ -0,0 +1,410 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include "perf_counters.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+namespace bench {
+    /**
+     * Keep the compiler from optimizing away the computation of `value`.
+     */
+    template <typename T>
+    inline void do_not_optimize(const T& value)
+    {
+#if defined(__GNUC__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+    /**
+     * Make the compiler assume that all memory was read and written.
+     */
+    inline void clobber_memory()
+    {
+#if defined(__GNUC__)
+        asm volatile("" : : : "memory");
+#endif
+    }
+
+    /**
+     * Fixed pattern of failures with exactly `percent` percent set, shuffled with a fixed seed so
+     * that runs are comparable while the branch predictor can not learn a short period.
+     */
+    inline std::vector<unsigned char> failure_pattern(unsigned percent, std::size_t size = 4096)
+    {
+        std::vector<unsigned char> pattern(size, 0);
+        std::fill(pattern.begin(), pattern.begin() + size * percent / 100, 1);
+        std::mt19937 random(12345);
+        std::shuffle(pattern.begin(), pattern.begin() + size, random);
+        return pattern;
+    }
+
+    typedef std::vector<std::pair<std::string, std::string>> params;
+
+    /**
+     * Benchmark body. Runs the measured operation `iterations` times.
+     */
+    typedef std::function<void(std::uint64_t iterations)> body;
+
+    /**
+     * Benchmark body run on several threads at once. Each thread runs the measured operation
+     * `iterations` times and gets its own index in `[0, threads)`.
+     */
+    typedef std::function<void(unsigned thread, std::uint64_t iterations)> threaded_body;
+
+    struct measurement final {
+        std::string name;
+        bench::params params;
+        unsigned threads;
+        std::uint64_t iterations;
+        std::vector<double> ns_per_op;
+        std::vector<counter_values> counters_per_op;
+    };
+
+    struct options final {
+        std::string filter;
+        std::string out;
+        double min_time_ms = 20;
+        unsigned repetitions = 5;
+        bool list = false;
+        bool counters = false;
+    };
+
+    inline std::string json_escape(const std::string& in)
+    {
+        std::string out;
+        for (auto c : in) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+            }
+            out += c;
+        }
+        return out;
+    }
+
+    class registry final {
+    private:
+        struct entry final {
+            std::string name;
+            bench::params params;
+            unsigned threads;
+            bench::threaded_body run;
+        };
+
+        std::vector<entry> entries;
+
+        /**
+         * Wall time of all threads running `iterations` each. Threads are started before the
+         * clock and released together, so thread creation is not measured. If `counters` is
+         * given, they run exactly while the clock does and their totals go to `totals`.
+         */
+        static double elapsed_ns(const entry& e,
+                                 std::uint64_t iterations,
+                                 perf_counters* counters = nullptr,
+                                 counter_values* totals = nullptr)
+        {
+            if (e.threads == 1) {
+                if (counters != nullptr) {
+                    counters->start();
+                }
+                auto start = std::chrono::steady_clock::now();
+                e.run(0, iterations);
+                auto end = std::chrono::steady_clock::now();
+                if (counters != nullptr) {
+                    *totals = counters->stop();
+                }
+                return std::chrono::duration<double, std::nano>(end - start).count();
+            }
+
+            std::atomic<unsigned> ready{0};
+            std::atomic<bool> go{false};
+            std::vector<std::thread> workers;
+            for (unsigned t = 0; t < e.threads; ++t) {
+                workers.emplace_back([&e, &ready, &go, t, iterations]() {
+                    ready.fetch_add(1);
+                    while (!go.load(std::memory_order_acquire)) {
+                        std::this_thread::yield();
+                    }
+                    e.run(t, iterations);
+                });
+            }
+            while (ready.load() != e.threads) {
+                std::this_thread::yield();
+            }
+            if (counters != nullptr) {
+                counters->start();
+            }
+            auto start = std::chrono::steady_clock::now();
+            go.store(true, std::memory_order_release);
+            for (auto& w : workers) {
+                w.join();
+            }
+            auto end = std::chrono::steady_clock::now();
+            if (counters != nullptr) {
+                *totals = counters->stop();
+            }
+            return std::chrono::duration<double, std::nano>(end - start).count();
+        }
+
+        static std::string full_name(const entry& e)
+        {
+            auto name = e.name;
+            for (auto& p : e.params) {
+                name += "/" + p.first + ":" + p.second;
+            }
+            if (e.threads != 1) {
+                name += "/threads:" + std::to_string(e.threads);
+            }
+            return name;
+        }
+
+        static measurement measure(const entry& e, const options& opts, perf_counters* counters)
+        {
+            auto min_ns = opts.min_time_ms * 1e6;
+            std::uint64_t iterations = 1;
+            for (;;) {
+                auto ns = elapsed_ns(e, iterations);
+                if (ns >= min_ns || iterations >= (std::uint64_t(1) << 40)) {
+                    break;
+                }
+                auto scale = ns <= 0 ? 10.0 : std::min(10.0, std::max(1.5, 1.2 * min_ns / ns));
+                iterations = static_cast<std::uint64_t>(iterations * scale) + 1;
+            }
+
+            measurement m{e.name, e.params, e.threads, iterations, {}, {}};
+            for (unsigned i = 0; i < opts.repetitions; ++i) {
+                counter_values totals;
+                m.ns_per_op.push_back(elapsed_ns(e, iterations, counters, &totals) / iterations);
+                if (counters != nullptr) {
+                    // Counters cover all threads, so they are per operation of any thread.
+                    for (auto& value : totals) {
+                        value /= static_cast<double>(iterations) * e.threads;
+                    }
+                    m.counters_per_op.push_back(totals);
+                }
+            }
+            return m;
+        }
+
+        /**
+         * Median of one counter over the repetitions, NaN if it was not available.
+         */
+        static double counter_median(const measurement& m, unsigned id)
+        {
+            std::vector<double> values;
+            for (auto& c : m.counters_per_op) {
+                if (!std::isnan(c[id])) {
+                    values.push_back(c[id]);
+                }
+            }
+            if (values.empty()) {
+                return std::nan("");
+            }
+            std::sort(values.begin(), values.end());
+            return values[values.size() / 2];
+        }
+
+        static void write_json(std::FILE* out,
+                               const std::vector<measurement>& results,
+                               const std::string& counters_status)
+        {
+            std::fprintf(out, "{\n  \"context\": {\n");
+#if defined(__VERSION__)
+            std::fprintf(out, "    \"compiler\": \"%s\",\n", json_escape(__VERSION__).c_str());
+#endif
+            std::fprintf(out, "    \"cplusplus\": %ld,\n", static_cast<long>(__cplusplus));
+            std::fprintf(out, "    \"hardware_concurrency\": %u,\n",
+                         std::thread::hardware_concurrency());
+            std::fprintf(
+                out, "    \"perf_counters\": \"%s\",\n", json_escape(counters_status).c_str());
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+            std::fprintf(out, "    \"exceptions\": true\n");
+#else
+            std::fprintf(out, "    \"exceptions\": false\n");
+#endif
+            std::fprintf(out, "  },\n  \"benchmarks\": [");
+            for (std::size_t i = 0; i < results.size(); ++i) {
+                auto& m = results[i];
+                auto sorted = m.ns_per_op;
+                std::sort(sorted.begin(), sorted.end());
+                std::fprintf(out, "%s\n    {\"name\": \"%s\", \"params\": {", i ? "," : "",
+                             json_escape(m.name).c_str());
+                for (std::size_t j = 0; j < m.params.size(); ++j) {
+                    std::fprintf(out, "%s\"%s\": \"%s\"", j ? ", " : "",
+                                 json_escape(m.params[j].first).c_str(),
+                                 json_escape(m.params[j].second).c_str());
+                }
+                auto median = sorted[sorted.size() / 2];
+                std::fprintf(out,
+                             "}, \"threads\": %u, \"iterations\": %llu, \"repetitions\": %zu, "
+                             "\"ns_per_op\": %.4f, \"min_ns_per_op\": %.4f, "
+                             "\"max_ns_per_op\": %.4f, \"ops_per_second\": %.1f",
+                             m.threads, static_cast<unsigned long long>(m.iterations),
+                             sorted.size(), median, sorted.front(), sorted.back(),
+                             median > 0 ? m.threads * 1e9 / median : 0.0);
+                if (!m.counters_per_op.empty()) {
+                    std::fprintf(out, ", \"counters_per_op\": {");
+                    for (unsigned id = 0; id < counter_count; ++id) {
+                        auto value = counter_median(m, id);
+                        std::fprintf(out, "%s\"%s\": ", id ? ", " : "", counter_name(id));
+                        if (std::isnan(value)) {
+                            std::fprintf(out, "null");
+                        } else {
+                            std::fprintf(out, "%.4f", value);
+                        }
+                    }
+                    std::fprintf(out, "}");
+                }
+                std::fprintf(out, "}");
+            }
+            std::fprintf(out, "\n  ]\n}\n");
+        }
+
+    public:
+        void add(std::string name, bench::params params, bench::body run)
+        {
+            entries.push_back(entry{std::move(name),
+                                    std::move(params),
+                                    1,
+                                    [run](unsigned, std::uint64_t n) { run(n); }});
+        }
+
+        /**
+         * Add a benchmark that runs on `threads` threads at once. `ns_per_op` is the wall time
+         * divided by the iterations of one thread, so it stays flat while throughput scales
+         * linearly.
+         */
+        void add_threaded(std::string name,
+                          bench::params params,
+                          unsigned threads,
+                          bench::threaded_body run)
+        {
+            entries.push_back(entry{std::move(name), std::move(params), threads, std::move(run)});
+        }
+
+        /**
+         * Run the registered benchmarks matching the command line filter. Writes JSON to
+         * stdout, or to the file given with `--out`, and a summary line per benchmark to
+         * stderr.
+         *
+         * @return process exit code
+         */
+        int run(int argc, char** argv)
+        {
+            options opts;
+            for (int i = 1; i < argc; ++i) {
+                auto arg = std::string(argv[i]);
+                auto value = [&]() -> std::string {
+                    if (i + 1 >= argc) {
+                        std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+                        std::exit(2);
+                    }
+                    return argv[++i];
+                };
+                if (arg == "--filter") {
+                    opts.filter = value();
+                } else if (arg == "--out") {
+                    opts.out = value();
+                } else if (arg == "--min-time-ms") {
+                    opts.min_time_ms = std::atof(value().c_str());
+                } else if (arg == "--repetitions") {
+                    opts.repetitions = std::max(1, std::atoi(value().c_str()));
+                } else if (arg == "--list") {
+                    opts.list = true;
+                } else if (arg == "--counters") {
+                    opts.counters = true;
+                } else {
+                    std::fprintf(stderr,
+                                 "usage: %s [--filter substring] [--out file.json] "
+                                 "[--min-time-ms ms] [--repetitions n] [--counters] [--list]\n",
+                                 argv[0]);
+                    return 2;
+                }
+            }
+
+            perf_counters counters;
+            auto counters_enabled = false;
+            std::string counters_status = "off";
+            if (opts.counters && !opts.list) {
+                std::string error;
+                counters_enabled = counters.open(error);
+                if (counters_enabled) {
+                    counters_status = "on";
+                } else {
+                    std::fprintf(stderr,
+                                 "performance counters unavailable, continuing without them: %s\n",
+                                 error.c_str());
+                    counters_status = "unavailable: " + error;
+                }
+            }
+
+            std::vector<measurement> results;
+            for (auto& e : entries) {
+                auto name = full_name(e);
+                if (name.find(opts.filter) == std::string::npos) {
+                    continue;
+                }
+                if (opts.list) {
+                    std::printf("%s\n", name.c_str());
+                    continue;
+                }
+                results.push_back(measure(e, opts, counters_enabled ? &counters : nullptr));
+                auto& m = results.back();
+                auto sorted = m.ns_per_op;
+                std::sort(sorted.begin(), sorted.end());
+                std::fprintf(stderr, "%-72s %10.3f ns/op", name.c_str(), sorted[sorted.size() / 2]);
+                if (counters_enabled) {
+                    std::fprintf(stderr, " %8.3f br-miss/op %8.1f insn/op",
+                                 counter_median(m, branch_misses), counter_median(m, instructions));
+                }
+                std::fprintf(stderr, "\n");
+            }
+            if (opts.list) {
+                return 0;
+            }
+
+            auto out = opts.out.empty() ? stdout : std::fopen(opts.out.c_str(), "w");
+            if (out == nullptr) {
+                std::fprintf(stderr, "can not open %s\n", opts.out.c_str());
+                return 1;
+            }
+            write_json(out, results, counters_status);
+            if (out != stdout) {
+                std::fclose(out);
+            }
+            return 0;
+        }
+    };
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#include "harness.hpp"
+
+namespace bench {
+    void register_construction(registry& r);
+    void register_chains(registry& r);
+    void register_propagation(registry& r);
+    void register_async(registry& r);
+    void register_contention(registry& r);
+    void register_error_paths(registry& r);
+    void register_error_paths_hot(registry& r);
+    void register_error_paths_cold(registry& r);
+}
+
+int main(int argc, char** argv)
+{
+    bench::registry r;
+    bench::register_construction(r);
+    bench::register_chains(r);
+    bench::register_propagation(r);
+    bench::register_async(r);
+    bench::register_contention(r);
+    bench::register_error_paths(r);
+    bench::register_error_paths_hot(r);
+    bench::register_error_paths_cold(r);
+    return r.run(argc, argv);
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+    enum counter_id : unsigned {
+        cycles,
+        instructions,
+        branch_misses,
+        l1d_read_misses,
+        counter_count,
+    };
+
+    inline const char* counter_name(unsigned id) noexcept
+    {
+        static const char* const names[counter_count]
+            = {"cycles", "instructions", "branch_misses", "l1d_read_misses"};
+        return names[id];
+    }
+
+    /**
+     * Counter totals of one measurement. Counters that could not be opened are NaN.
+     */
+    typedef std::array<double, counter_count> counter_values;
+
+    /**
+     * Hardware performance counters of the calling thread and the threads it starts afterwards,
+     * read with Linux `perf_event_open`.
+     *
+     * Each counter is opened on its own, so that a missing one (e.g. no L1d events on a virtual
+     * machine) does not disable the others. Counters are commonly unavailable in containers or
+     * with a restrictive `perf_event_paranoid`; `open` then reports why and the benchmarks run
+     * without them. Values are scaled by enabled over running time when the kernel multiplexes
+     * counters.
+     */
+    class perf_counters final {
+    private:
+        struct reading final {
+            std::uint64_t value;
+            std::uint64_t enabled;
+            std::uint64_t running;
+        };
+
+        std::array<int, counter_count> fds;
+        std::array<reading, counter_count> started;
+
+        bool read(unsigned id, reading& out) const noexcept
+        {
+#if defined(__linux__)
+            return fds[id] >= 0 && ::read(fds[id], &out, sizeof(out)) == sizeof(out);
+#else
+            (void)id;
+            (void)out;
+            return false;
+#endif
+        }
+
+    public:
+        perf_counters() noexcept
+        {
+            fds.fill(-1);
+            started.fill(reading{0, 0, 0});
+        }
+
+        perf_counters(const perf_counters&) = delete;
+        perf_counters& operator=(const perf_counters&) = delete;
+
+        ~perf_counters()
+        {
+#if defined(__linux__)
+            for (auto fd : fds) {
+                if (fd >= 0) {
+                    ::close(fd);
+                }
+            }
+#endif
+        }
+
+        /**
+         * Open the counters. Must be called before the threads to be counted are started.
+         *
+         * @param error set to the reason when no counter could be opened
+         * @return true if at least one counter is available
+         */
+        bool open(std::string& error)
+        {
+#if defined(__linux__)
+            const std::uint64_t configs[counter_count] = {
+                PERF_COUNT_HW_CPU_CYCLES,
+                PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_BRANCH_MISSES,
+                PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+            };
+            bool any = false;
+            for (unsigned id = 0; id < counter_count; ++id) {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = id == l1d_read_misses ? PERF_TYPE_HW_CACHE : PERF_TYPE_HARDWARE;
+                attr.config = configs[id];
+                attr.disabled = 1;
+                attr.inherit = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format
+                    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                auto fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+                if (fd < 0) {
+                    if (error.empty()) {
+                        error = std::string("perf_event_open: ") + std::strerror(errno);
+                    }
+                    continue;
+                }
+                fds[id] = fd;
+                any = true;
+            }
+            if (any) {
+                error.clear();
+            }
+            return any;
+#else
+            error = "perf_event_open is only available on Linux";
+            return false;
+#endif
+        }
+
+        /**
+         * Start the open counters.
+         *
+         * Counts of threads that already exited can not be reset, so `stop` reports the
+         * difference to the values read here.
+         */
+        void start() noexcept
+        {
+#if defined(__linux__)
+            for (unsigned id = 0; id < counter_count; ++id) {
+                if (fds[id] >= 0) {
+                    read(id, started[id]);
+                    ::ioctl(fds[id], PERF_EVENT_IOC_ENABLE, 0);
+                }
+            }
+#endif
+        }
+
+        /**
+         * Stop the counters and read their totals since `start`.
+         *
+         * @return bench::counter_values
+         */
+        counter_values stop() noexcept
+        {
+            counter_values out;
+            out.fill(std::numeric_limits<double>::quiet_NaN());
+#if defined(__linux__)
+            for (unsigned id = 0; id < counter_count; ++id) {
+                if (fds[id] >= 0) {
+                    ::ioctl(fds[id], PERF_EVENT_IOC_DISABLE, 0);
+                }
+            }
+            for (unsigned id = 0; id < counter_count; ++id) {
+                reading now;
+                if (!read(id, now) || now.running == started[id].running) {
+                    continue;
+                }
+                out[id] = static_cast<double>(now.value - started[id].value)
+                    * (now.enabled - started[id].enabled) / (now.running - started[id].running);
+            }
+#endif
+            return out;
+        }
+    };
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#include "frames.hpp"
+#include "harness.hpp"
+
+#include <maybe/result.hpp>
+#include <string>
+
+using maybe::result;
+
+// Each strategy forwards a failure through `Depth` frames from frames.hpp.
+namespace bench {
+    namespace {
+        template <int Depth>
+        void add_depth(registry& r, unsigned percent)
+        {
+            auto pattern = failure_pattern(percent);
+            auto mask = pattern.size() - 1;
+            params p{{"depth", std::to_string(Depth)}, {"error_rate", std::to_string(percent)}};
+
+            r.add("propagate_result", p, [pattern, mask](std::uint64_t n) {
+                int sum = 0;
+                for (std::uint64_t i = 0; i < n; ++i) {
+                    auto out = result_frames<Depth>::call(static_cast<int>(i), pattern[i & mask]);
+                    sum += out.is_ok() ? out.ok_value() : out.err_value();
+                }
+                do_not_optimize(sum);
+            });
+
+            r.add("propagate_error_code", p, [pattern, mask](std::uint64_t n) {
+                int sum = 0;
+                for (std::uint64_t i = 0; i < n; ++i) {
+                    int value;
+                    auto code = code_frames<Depth>::call(static_cast<int>(i), pattern[i & mask], value);
+                    sum += code ? code : value;
+                }
+                do_not_optimize(sum);
+            });
+
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+            r.add("propagate_exception", p, [pattern, mask](std::uint64_t n) {
+                int sum = 0;
+                for (std::uint64_t i = 0; i < n; ++i) {
+                    try {
+                        sum += throw_frames<Depth>::call(static_cast<int>(i), pattern[i & mask]);
+                    } catch (const frame_error& e) {
+                        sum += e.code;
+                    }
+                }
+                do_not_optimize(sum);
+            });
+#endif
+        }
+    }
+
+    void register_propagation(registry& r)
+    {
+        for (auto percent : {0u, 1u, 10u, 50u}) {
+            add_depth<1>(r, percent);
+            add_depth<8>(r, percent);
+            add_depth<32>(r, percent);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#
+# Copyright 2016 TRAFI
+#
+# Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+# http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+# http://opensource.org/licenses/MIT>, at your option. This file may not be
+# copied, modified, or distributed except according to those terms.
+#
+
+# Binary size budget. Compiles size_corpus.cpp with and without exceptions and fails if the
+# .text, .eh_frame or .gcc_except_table sections grow past the budget. Run with cmake -P and:
+#
+#   COMPILER    C++ compiler
+#   SIZE_TOOL   binutils or LLVM `size`
+#   INCLUDES    ;-separated include directories
+#   WORK_DIR    directory for the object files
+#   BUDGET      file setting BUDGET_<configuration>_<section> in bytes, e.g. size_budget.cmake
+#
+# Sections split per function (.text.unlikely, .text.<symbol>, ...) count towards their base
+# section.
+
+foreach(var COMPILER SIZE_TOOL WORK_DIR BUDGET)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "${var} is not set")
+    endif()
+endforeach()
+
+include(${BUDGET})
+
+set(include_flags "")
+foreach(dir ${INCLUDES})
+    if(dir)
+        list(APPEND include_flags "-I${dir}")
+    endif()
+endforeach()
+
+set(configurations exceptions no_exceptions)
+set(flags_exceptions -fexceptions)
+set(flags_no_exceptions -fno-exceptions)
+set(sections text eh_frame gcc_except_table)
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+set(failures "")
+foreach(configuration IN LISTS configurations)
+    set(object ${WORK_DIR}/size_corpus_${configuration}.o)
+    execute_process(
+            COMMAND ${COMPILER} -std=c++14 -O2 ${flags_${configuration}} ${include_flags}
+                    -c ${CMAKE_CURRENT_LIST_DIR}/size_corpus.cpp -o ${object}
+            RESULT_VARIABLE status
+            ERROR_VARIABLE errors)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "compiling size_corpus.cpp (${configuration}) failed:\n${errors}")
+    endif()
+
+    execute_process(
+            COMMAND ${SIZE_TOOL} -A ${object}
+            RESULT_VARIABLE status
+            OUTPUT_VARIABLE listing
+            ERROR_VARIABLE errors)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "${SIZE_TOOL} failed:\n${errors}")
+    endif()
+    string(REPLACE "\n" ";" listing "${listing}")
+
+    foreach(section IN LISTS sections)
+        set(bytes 0)
+        foreach(line IN LISTS listing)
+            if(line MATCHES "^\\.${section}(\\.[^ \t]*)?[ \t]+([0-9]+)")
+                math(EXPR bytes "${bytes} + ${CMAKE_MATCH_2}")
+            endif()
+        endforeach()
+
+        set(budget ${BUDGET_${configuration}_${section}})
+        message(STATUS "${configuration} .${section}: ${bytes} bytes (budget ${budget})")
+        if(bytes GREATER budget)
+            list(APPEND failures "${configuration} .${section} is ${bytes} bytes, budget ${budget}")
+        endif()
+    endforeach()
+endforeach()
+
+if(failures)
+    string(REPLACE ";" "\n  " failures "${failures}")
+    message(FATAL_ERROR "size budget exceeded:\n  ${failures}")
+endif()
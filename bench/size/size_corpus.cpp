@@ -0,0 +1,119 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+// Fixed corpus of result-using code measured by check_size.cmake. Changing it changes the
+// measured sizes, so update bench/size/size_budget.cmake in the same change.
+
+#include <maybe/result.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using maybe::result;
+
+namespace corpus {
+    enum class parse_error {
+        empty,
+        invalid_digit,
+        overflow,
+    };
+
+    struct config final {
+        int port;
+        int workers;
+        std::string name;
+    };
+
+    result<int, parse_error> parse_digit(char c)
+    {
+        if (c < '0' || c > '9') {
+            return result<int, parse_error>::err(parse_error::invalid_digit);
+        }
+        return result<int, parse_error>::ok(c - '0');
+    }
+
+    result<int, parse_error> parse_number(const std::string& text)
+    {
+        if (text.empty()) {
+            return result<int, parse_error>::err(parse_error::empty);
+        }
+        auto value = result<int, parse_error>::ok(0);
+        for (auto c : text) {
+            value = value.and_then([c](int v) {
+                return parse_digit(c).and_then([v](int d) {
+                    return v > 214748364 ? result<int, parse_error>::err(parse_error::overflow)
+                                         : result<int, parse_error>::ok(v * 10 + d);
+                });
+            });
+        }
+        return value;
+    }
+
+    result<void, std::string> validate_port(int port)
+    {
+        if (port <= 0 || port > 65535) {
+            return result<void, std::string>::err("port out of range");
+        }
+        return result<void, std::string>::ok();
+    }
+
+    std::string describe(parse_error e)
+    {
+        switch (e) {
+        case parse_error::empty:
+            return "empty";
+        case parse_error::invalid_digit:
+            return "invalid digit";
+        case parse_error::overflow:
+            return "overflow";
+        }
+        return "unknown";
+    }
+
+    result<int, std::string> parse_port(const std::string& text)
+    {
+        return parse_number(text).map_err(describe).and_then([](int port) {
+            return validate_port(port).map_value(port);
+        });
+    }
+
+    result<config, std::string> parse_config(const std::vector<std::string>& fields)
+    {
+        if (fields.size() != 3) {
+            return result<config, std::string>::err("expected 3 fields");
+        }
+        return parse_port(fields[0]).and_then([&fields](int port) {
+            return parse_number(fields[1]).map_err(describe).map([&fields, port](int workers) {
+                return config{port, workers, fields[2]};
+            });
+        });
+    }
+
+    int port_or_default(const std::string& text)
+    {
+        return parse_port(text).ok_value_or(8080);
+    }
+
+    int port_or_throw(const std::string& text)
+    {
+        auto port = parse_port(text);
+        return port.ok_value();
+    }
+
+    std::size_t count_valid(const std::vector<std::string>& texts)
+    {
+        std::size_t count = 0;
+        for (auto& text : texts) {
+            count += parse_port(text).is_ok();
+        }
+        return count;
+    }
+}
@@ -0,0 +1,595 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include "atomic_wait.hpp"
+#include "cancel_token.hpp"
+#include "result.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace maybe {
+    template <typename T, typename E>
+    class async_result;
+
+    template <typename T, typename E>
+    class async_promise;
+
+    /**
+     * Executor that runs work immediately on the calling thread.
+     *
+     * Any type with `execute(F)` accepting a move-only `void()` callable can be used in place of
+     * it.
+     */
+    struct inline_executor final {
+        template <typename F>
+        void execute(F&& f)
+        {
+            f();
+        }
+    };
+
+    /**
+     * Makes the err value `E` delivered by an async_promise that is destroyed without being set.
+     *
+     * By default `E` is value-initialized. Specialize this template for error types that need a
+     * distinguishable value.
+     */
+    template <typename E>
+    struct broken_promise_error {
+        static E make()
+        {
+            return E();
+        }
+    };
+
+    namespace internal {
+        /**
+         * Move-only, type erased `void(Arg)` callable.
+         */
+        template <typename Arg>
+        class unique_callback final {
+        private:
+            struct callable {
+                virtual ~callable()
+                {
+                }
+                virtual void call(Arg arg) = 0;
+            };
+
+            template <typename F>
+            struct callable_impl final : callable {
+                F f;
+
+                explicit callable_impl(F&& f) : f(std::move(f))
+                {
+                }
+
+                void call(Arg arg) override
+                {
+                    f(std::forward<Arg>(arg));
+                }
+            };
+
+            std::unique_ptr<callable> impl;
+
+        public:
+            unique_callback() noexcept
+            {
+            }
+
+            template <typename F>
+            unique_callback(F f) : impl(new callable_impl<F>(std::move(f)))
+            {
+            }
+
+            explicit operator bool() const noexcept
+            {
+                return !!impl;
+            }
+
+            void operator()(Arg arg)
+            {
+                impl->call(std::forward<Arg>(arg));
+            }
+        };
+
+        enum async_status : unsigned {
+            async_pending = 0,
+            async_has_continuation = 1,
+            async_ready = 2,
+        };
+
+        /**
+         * State shared by a promise and its async result. The single `status` word orders the
+         * hand-off of the value from the producer and of the continuation from the consumer:
+         * whoever comes second runs the continuation.
+         */
+        template <typename T, typename E>
+        struct async_state final {
+            std::atomic<unsigned> status{async_pending};
+            // Number of async_promise copies, the last one to go sets an unset state.
+            std::atomic<std::size_t> promises{1};
+            maybe::result<T, E> value;
+            unique_callback<maybe::result<T, E>&&> continuation;
+
+            void set(maybe::result<T, E>&& r)
+            {
+                value = std::move(r);
+                if (status.exchange(async_ready, std::memory_order_acq_rel)
+                    == async_has_continuation) {
+                    auto c = std::move(continuation);
+                    c(std::move(value));
+                }
+                atomic_notify_all(status);
+            }
+
+            void subscribe(unique_callback<maybe::result<T, E>&&>&& c)
+            {
+                continuation = std::move(c);
+                unsigned expected = async_pending;
+                if (!status.compare_exchange_strong(expected,
+                                                    async_has_continuation,
+                                                    std::memory_order_acq_rel,
+                                                    std::memory_order_acquire)) {
+                    auto ready = std::move(continuation);
+                    ready(std::move(value));
+                }
+            }
+
+            void wait() const noexcept
+            {
+                unsigned current;
+                while ((current = status.load(std::memory_order_acquire)) != async_ready) {
+                    atomic_wait(status, current);
+                }
+            }
+        };
+
+        inline inline_executor& default_executor() noexcept
+        {
+            static inline_executor executor;
+            return executor;
+        }
+
+        template <typename R>
+        struct async_traits {
+            typedef R result_type;
+        };
+
+        template <typename T, typename E>
+        struct async_traits<async_result<T, E>> {
+            typedef maybe::result<T, E> result_type;
+        };
+
+        /**
+         * Calls F with the ok value of a result, or with no arguments for result<void, E>.
+         */
+        template <typename T>
+        struct ok_call final {
+            template <typename F, typename R>
+            static auto invoke(F& f, R& r) -> decltype(f(std::move(r.ok_value())))
+            {
+                return f(std::move(r.ok_value()));
+            }
+        };
+
+        template <>
+        struct ok_call<void> final {
+            template <typename F, typename R>
+            static auto invoke(F& f, R&) -> decltype(f())
+            {
+                return f();
+            }
+        };
+
+        template <typename F, typename T>
+        struct ok_call_result {
+            typedef typename std::result_of<F(T)>::type type;
+        };
+
+        template <typename F>
+        struct ok_call_result<F, void> {
+            typedef typename std::result_of<F()>::type type;
+        };
+
+        template <typename F, typename T>
+        using ok_call_t = typename ok_call_result<F, T>::type;
+
+        /**
+         * Moves the ok value of a result into a result with a different err type.
+         */
+        template <typename T>
+        struct ok_move final {
+            template <typename U, typename R>
+            static maybe::result<T, U> into(R& r)
+            {
+                return maybe::result<T, U>::ok(std::move(r.ok_value()));
+            }
+        };
+
+        template <>
+        struct ok_move<void> final {
+            template <typename U, typename R>
+            static maybe::result<void, U> into(R&)
+            {
+                return maybe::result<void, U>::ok();
+            }
+        };
+
+        template <typename T, typename E>
+        void settle(async_promise<T, E>& promise, maybe::result<T, E>&& r)
+        {
+            promise.set(std::move(r));
+        }
+
+        template <typename T, typename E>
+        void settle(async_promise<T, E>& promise, async_result<T, E>&& r)
+        {
+            std::move(r).on_ready([promise = std::move(promise)](maybe::result<T, E>&& r) mutable {
+                promise.set(std::move(r));
+            });
+        }
+    }
+
+    /**
+     * Producer side of an async_result. Setting the value runs the registered continuation, if
+     * any, on the setting thread.
+     *
+     * Copies refer to the same value. If the last copy is destroyed without setting it, the
+     * value is set to `maybe::broken_promise_error<E>::make()`, so that waiters and
+     * continuations still complete when a producer is dropped.
+     */
+    template <typename T, typename E>
+    class async_promise final {
+    private:
+        std::shared_ptr<internal::async_state<T, E>> state;
+
+        void release()
+        {
+            if (state && state->promises.fetch_sub(1, std::memory_order_acq_rel) == 1
+                && state->status.load(std::memory_order_acquire) != internal::async_ready) {
+                state->set(maybe::result<T, E>(internal::placeholder{},
+                                               broken_promise_error<E>::make()));
+            }
+        }
+
+    public:
+        async_promise() : state(std::make_shared<internal::async_state<T, E>>())
+        {
+        }
+
+        async_promise(const async_promise& other) noexcept : state(other.state)
+        {
+            if (state) {
+                state->promises.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        async_promise(async_promise&& other) noexcept : state(std::move(other.state))
+        {
+        }
+
+        async_promise& operator=(async_promise other)
+        {
+            release();
+            state = std::move(other.state);
+            return *this;
+        }
+
+        ~async_promise()
+        {
+            release();
+        }
+
+        /**
+         * Get the async result that receives the value of this promise.
+         *
+         * @return maybe::async_result<T, E>
+         */
+        async_result<T, E> get_async_result() const
+        {
+            return async_result<T, E>(state);
+        }
+
+        /**
+         * Set the value. Must be called at most once.
+         *
+         * @param r maybe::result<T, E>
+         */
+        void set(maybe::result<T, E>&& r)
+        {
+            state->set(std::move(r));
+        }
+
+        void set(const maybe::result<T, E>& r)
+        {
+            state->set(maybe::result<T, E>(r));
+        }
+    };
+
+    /**
+     * Result of an asynchronous operation, which can be waited on or chained with continuations.
+     *
+     * Continuations receive the value on the thread that sets it and then schedule the user
+     * function on an executor. A continuation that does not apply to the value (`map` and
+     * `and_then` on err, `map_err` on ok) forwards it downstream directly, without scheduling
+     * anything.
+     *
+     * Continuations and `get` consume the async result, and only one of them may be used. The
+     * executor passed to a continuation must outlive it.
+     */
+    template <typename T, typename E>
+    class async_result final {
+    private:
+        std::shared_ptr<internal::async_state<T, E>> state;
+
+        friend class async_promise<T, E>;
+
+        explicit async_result(std::shared_ptr<internal::async_state<T, E>> state)
+            : state(std::move(state))
+        {
+        }
+
+    public:
+        typedef T ok_type;
+        typedef E err_type;
+
+        async_result() noexcept
+        {
+        }
+
+        /**
+         * Create an async result that is already set.
+         *
+         * @param r maybe::result<T, E>
+         * @return maybe::async_result<T, E>
+         */
+        static async_result<T, E> ready(maybe::result<T, E>&& r)
+        {
+            async_promise<T, E> promise;
+            auto out = promise.get_async_result();
+            promise.set(std::move(r));
+            return out;
+        }
+
+        /**
+         * Check if this async result still refers to a value that was not consumed.
+         *
+         * @return bool
+         */
+        bool valid() const noexcept
+        {
+            return !!state;
+        }
+
+        /**
+         * Check if the value was set.
+         *
+         * @return bool
+         */
+        bool is_ready() const noexcept
+        {
+            return state->status.load(std::memory_order_acquire) == internal::async_ready;
+        }
+
+        /**
+         * Block until the value is set.
+         */
+        void wait() const noexcept
+        {
+            state->wait();
+        }
+
+        /**
+         * Block until the value is set and move it out.
+         *
+         * @return maybe::result<T, E>
+         */
+        maybe::result<T, E> get() &&
+        {
+            auto s = std::move(state);
+            s->wait();
+            return std::move(s->value);
+        }
+
+        /**
+         * Register a callback that receives the value on the thread that sets it, or immediately
+         * if it is already set.
+         *
+         * @param f F(maybe::result<T, E>&&)
+         */
+        template <typename F>
+        void on_ready(F f) &&
+        {
+            auto s = std::move(state);
+            s->subscribe(internal::unique_callback<maybe::result<T, E>&&>(std::move(f)));
+        }
+
+        /**
+         * Maps the ok value with F on the executor, forwarding an err value without scheduling.
+         *
+         * @param f F(T) -> U, where U may be void
+         * @return maybe::async_result<U, E>
+         */
+        template <typename Executor, typename F, typename U = internal::ok_call_t<F, T>>
+        auto map(Executor& executor, F f) && -> async_result<U, E>
+        {
+            async_promise<U, E> promise;
+            auto out = promise.get_async_result();
+
+            std::move(*this).on_ready([&executor, f = std::move(f), promise = std::move(promise)](
+                maybe::result<T, E>&& r) mutable {
+                if (r.is_err()) {
+                    promise.set(maybe::result<U, E>(internal::placeholder{},
+                                                    std::move(r.err_value())));
+                    return;
+                }
+                executor.execute([f = std::move(f),
+                                  promise = std::move(promise),
+                                  r = std::move(r)]() mutable {
+                    auto call = [&f, &r]() { return internal::ok_call<T>::invoke(f, r); };
+                    promise.set(internal::ok_of_call<maybe::result<U, E>>::call(call));
+                });
+            });
+
+            return out;
+        }
+
+        template <typename F, typename U = internal::ok_call_t<F, T>>
+        auto map(F f) && -> async_result<U, E>
+        {
+            return std::move(*this).map(internal::default_executor(), std::move(f));
+        }
+
+        /**
+         * Calls F with the ok value on the executor, forwarding an err value without scheduling.
+         * F may return either a result or another async result.
+         *
+         * @param f F(T) -> maybe::result<U, E> or maybe::async_result<U, E>
+         * @return maybe::async_result<U, E>
+         */
+        template <typename Executor,
+                  typename F,
+                  typename R = typename internal::async_traits<internal::ok_call_t<F, T>>::result_type>
+        auto and_then(Executor& executor, F f) && -> async_result<typename R::ok_type, E>
+        {
+            typedef typename R::ok_type U;
+            static_assert(std::is_same<typename R::err_type, E>::value,
+                          "and_then requires a function returning the same err type");
+
+            async_promise<U, E> promise;
+            auto out = promise.get_async_result();
+
+            std::move(*this).on_ready([&executor, f = std::move(f), promise = std::move(promise)](
+                maybe::result<T, E>&& r) mutable {
+                if (r.is_err()) {
+                    promise.set(R(internal::placeholder{}, std::move(r.err_value())));
+                    return;
+                }
+                executor.execute([f = std::move(f),
+                                  promise = std::move(promise),
+                                  r = std::move(r)]() mutable {
+                    internal::settle(promise, internal::ok_call<T>::invoke(f, r));
+                });
+            });
+
+            return out;
+        }
+
+        template <typename F,
+                  typename R = typename internal::async_traits<internal::ok_call_t<F, T>>::result_type>
+        auto and_then(F f) && -> async_result<typename R::ok_type, E>
+        {
+            return std::move(*this).and_then(internal::default_executor(), std::move(f));
+        }
+
+        /**
+         * Like `and_then`, but once the token is cancelled F is not called and an err value
+         * converted from the cancel reason with `maybe::cancel_error<E>` is forwarded instead.
+         * The token is checked before scheduling F and again right before calling it.
+         *
+         * @param token maybe::cancel_token
+         * @param f F(T) -> maybe::result<U, E> or maybe::async_result<U, E>
+         * @return maybe::async_result<U, E>
+         */
+        template <typename Executor,
+                  typename F,
+                  typename R = typename internal::async_traits<internal::ok_call_t<F, T>>::result_type>
+        auto and_then(Executor& executor, cancel_token token, F f) &&
+            -> async_result<typename R::ok_type, E>
+        {
+            typedef typename R::ok_type U;
+            static_assert(std::is_same<typename R::err_type, E>::value,
+                          "and_then requires a function returning the same err type");
+
+            async_promise<U, E> promise;
+            auto out = promise.get_async_result();
+
+            std::move(*this).on_ready([&executor,
+                                       token = std::move(token),
+                                       f = std::move(f),
+                                       promise = std::move(promise)](
+                maybe::result<T, E>&& r) mutable {
+                if (r.is_err()) {
+                    promise.set(R(internal::placeholder{}, std::move(r.err_value())));
+                    return;
+                }
+                if (token.is_cancelled()) {
+                    promise.set(R(internal::placeholder{}, cancel_error<E>::make(token.reason())));
+                    return;
+                }
+                executor.execute([token = std::move(token),
+                                  f = std::move(f),
+                                  promise = std::move(promise),
+                                  r = std::move(r)]() mutable {
+                    if (token.is_cancelled()) {
+                        promise.set(
+                            R(internal::placeholder{}, cancel_error<E>::make(token.reason())));
+                        return;
+                    }
+                    internal::settle(promise, internal::ok_call<T>::invoke(f, r));
+                });
+            });
+
+            return out;
+        }
+
+        template <typename F,
+                  typename R = typename internal::async_traits<internal::ok_call_t<F, T>>::result_type>
+        auto and_then(cancel_token token, F f) && -> async_result<typename R::ok_type, E>
+        {
+            return std::move(*this).and_then(
+                internal::default_executor(), std::move(token), std::move(f));
+        }
+
+        /**
+         * Maps the err value with F on the executor, forwarding an ok value without scheduling.
+         *
+         * @param f F(E) -> U
+         * @return maybe::async_result<T, U>
+         */
+        template <typename Executor,
+                  typename F,
+                  typename U = typename std::result_of<F(E)>::type>
+        auto map_err(Executor& executor, F f) && -> async_result<T, U>
+        {
+            async_promise<T, U> promise;
+            auto out = promise.get_async_result();
+
+            std::move(*this).on_ready([&executor, f = std::move(f), promise = std::move(promise)](
+                maybe::result<T, E>&& r) mutable {
+                if (r.is_ok()) {
+                    promise.set(internal::ok_move<T>::template into<U>(r));
+                    return;
+                }
+                executor.execute([f = std::move(f),
+                                  promise = std::move(promise),
+                                  r = std::move(r)]() mutable {
+                    promise.set(maybe::result<T, U>(internal::placeholder{},
+                                                    f(std::move(r.err_value()))));
+                });
+            });
+
+            return out;
+        }
+
+        template <typename F, typename U = typename std::result_of<F(E)>::type>
+        auto map_err(F f) && -> async_result<T, U>
+        {
+            return std::move(*this).map_err(internal::default_executor(), std::move(f));
+        }
+    };
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include "atomic_wait.hpp"
+#include "result.hpp"
+
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace maybe {
+    /**
+     * Write-once cell that publishes a result to many threads.
+     *
+     * The first `set` or `get_or_compute` stores the result, later ones have no effect. Once
+     * stored, the result is immutable and readers access it with a single acquire load instead
+     * of a lock.
+     */
+    template <typename T, typename E>
+    class atomic_result final {
+    public:
+        typedef result<T, E> value_type;
+
+    private:
+        enum cell_state : unsigned char {
+            empty = 0,
+            writing = 1,
+            ready = 2,
+        };
+
+        std::atomic<unsigned char> state{empty};
+        typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type storage;
+
+        const value_type* value() const noexcept
+        {
+            return reinterpret_cast<const value_type*>(&storage);
+        }
+
+        bool try_claim() noexcept
+        {
+            unsigned char expected = empty;
+            return state.compare_exchange_strong(
+                expected, writing, std::memory_order_acquire, std::memory_order_relaxed);
+        }
+
+        void publish(value_type&& r) noexcept
+        {
+            ::new (static_cast<void*>(&storage)) value_type(std::move(r));
+            state.store(ready, std::memory_order_release);
+            internal::atomic_notify_all(state);
+        }
+
+        /**
+         * Store the result of `f`, or empty the cell again if `f` throws, so that a waiting
+         * caller can compute it instead.
+         */
+        template <typename F>
+        void compute(F&& f)
+        {
+#if MAYBE_RESULT_HAS_EXCEPTIONS
+            try {
+                publish(std::forward<F>(f)());
+            } catch (...) {
+                state.store(empty, std::memory_order_release);
+                internal::atomic_notify_all(state);
+                throw;
+            }
+#else
+            publish(std::forward<F>(f)());
+#endif
+        }
+
+    public:
+        atomic_result() = default;
+
+        atomic_result(const atomic_result&) = delete;
+        atomic_result& operator=(const atomic_result&) = delete;
+
+        ~atomic_result()
+        {
+            if (state.load(std::memory_order_acquire) == ready) {
+                value()->~value_type();
+            }
+        }
+
+        /**
+         * Store the result unless one is already stored or being stored.
+         *
+         * @param r maybe::result<T, E>
+         * @return true if this call stored the result
+         */
+        bool set(value_type r) noexcept
+        {
+            if (!try_claim()) {
+                return false;
+            }
+            publish(std::move(r));
+            return true;
+        }
+
+        /**
+         * Check if the result was stored.
+         *
+         * @return bool
+         */
+        bool is_ready() const noexcept
+        {
+            return state.load(std::memory_order_acquire) == ready;
+        }
+
+        /**
+         * Get the stored result without blocking.
+         *
+         * @return pointer to the result, or nullptr if it was not stored yet
+         */
+        const value_type* try_get() const noexcept
+        {
+            return is_ready() ? value() : nullptr;
+        }
+
+        /**
+         * Block until the result is stored.
+         *
+         * @return const maybe::result<T, E>&
+         */
+        const value_type& wait() const noexcept
+        {
+            for (auto s = state.load(std::memory_order_acquire); s != ready;
+                 s = state.load(std::memory_order_acquire)) {
+                internal::atomic_wait(state, s);
+            }
+            return *value();
+        }
+
+        /**
+         * Get the stored result, computing it with `f` if nothing is stored yet.
+         *
+         * When several threads call this concurrently on an empty cell, only one of them runs
+         * `f` and the others wait for its result. If `f` throws, the cell is left empty and the
+         * exception propagates, and a caller waiting for it runs its own `f` instead.
+         *
+         * @param f F() -> maybe::result<T, E>
+         * @return const maybe::result<T, E>&
+         */
+        template <typename F>
+        const value_type& get_or_compute(F&& f)
+        {
+            for (auto s = state.load(std::memory_order_acquire); s != ready;
+                 s = state.load(std::memory_order_acquire)) {
+                if (s == writing) {
+                    internal::atomic_wait(state, s);
+                } else if (try_claim()) {
+                    compute(std::forward<F>(f));
+                }
+            }
+            return *value();
+        }
+    };
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace maybe {
+    namespace internal {
+        /**
+         * Parking slot shared by all atomics whose address hashes to it. `waiters` lets
+         * `atomic_notify_all` skip the lock when nobody is parked.
+         */
+        struct wait_bucket final {
+            std::mutex mutex;
+            std::condition_variable parked;
+            std::atomic<std::size_t> waiters{0};
+        };
+
+        inline wait_bucket& wait_bucket_of(const void* address) noexcept
+        {
+            static wait_bucket buckets[64];
+            auto bits = reinterpret_cast<std::uintptr_t>(address);
+            return buckets[(bits >> 4 ^ bits >> 10) % 64];
+        }
+
+        /**
+         * Blocks while `value` holds `old`. Uses `std::atomic::wait` where the standard library
+         * provides it (C++20). Otherwise spins briefly, then parks the thread on a condition
+         * variable in a table keyed by the address of `value` until `atomic_notify_all`, so that
+         * a blocked waiter neither polls nor burns CPU.
+         */
+        template <typename T>
+        void atomic_wait(const std::atomic<T>& value, T old) noexcept
+        {
+#if defined(__cpp_lib_atomic_wait)
+            value.wait(old, std::memory_order_acquire);
+#else
+            for (unsigned spins = 0; spins < 128; ++spins) {
+                if (value.load(std::memory_order_acquire) != old) {
+                    return;
+                }
+                if (spins >= 64) {
+                    std::this_thread::yield();
+                }
+            }
+
+            auto& bucket = wait_bucket_of(&value);
+            std::unique_lock<std::mutex> lock(bucket.mutex);
+            bucket.waiters.fetch_add(1, std::memory_order_relaxed);
+            // Pairs with the fence in atomic_notify_all: either the notifier sees this waiter,
+            // or this load sees the new value.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            while (value.load(std::memory_order_acquire) == old) {
+                bucket.parked.wait(lock);
+            }
+            bucket.waiters.fetch_sub(1, std::memory_order_relaxed);
+#endif
+        }
+
+        /**
+         * Wakes all threads blocked in `atomic_wait` on `value`. `value` must still be alive:
+         * `std::atomic::notify_all` accesses it, so callers must keep a waiter that was woken by
+         * the change from destroying it until this returns.
+         */
+        template <typename T>
+        void atomic_notify_all(std::atomic<T>& value) noexcept
+        {
+#if defined(__cpp_lib_atomic_wait)
+            value.notify_all();
+#else
+            auto& bucket = wait_bucket_of(&value);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (bucket.waiters.load(std::memory_order_relaxed) == 0) {
+                return;
+            }
+            // Taking the lock orders this notification after a waiter that already checked the
+            // value has started waiting.
+            {
+                std::lock_guard<std::mutex> lock(bucket.mutex);
+            }
+            bucket.parked.notify_all();
+#endif
+        }
+    }
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include "result.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <type_traits>
+
+namespace maybe {
+    /**
+     * Why a cancel_token stopped a pipeline.
+     */
+    enum class cancel_reason {
+        cancelled,
+        deadline_exceeded,
+    };
+
+    /**
+     * Converts a cancel_reason into the err type `E` of a pipeline stopped by a cancel_token.
+     *
+     * By default `E` is constructed from the reason. Specialize this template for error types
+     * that need a different conversion.
+     */
+    template <typename E>
+    struct cancel_error {
+        static E make(cancel_reason reason)
+        {
+            return E(reason);
+        }
+    };
+
+    namespace internal {
+        enum cancel_flags : unsigned {
+            cancel_live = 0,
+            cancel_has_deadline = 1,
+            cancel_requested = 2,
+            cancel_expired = 4,
+        };
+
+        struct cancel_state final {
+            std::atomic<unsigned> flags;
+            const std::chrono::steady_clock::time_point deadline;
+
+            cancel_state()
+                : flags(cancel_live), deadline(std::chrono::steady_clock::time_point::max())
+            {
+            }
+
+            explicit cancel_state(std::chrono::steady_clock::time_point deadline)
+                : flags(cancel_has_deadline), deadline(deadline)
+            {
+            }
+        };
+    }
+
+    /**
+     * Shared cancellation flag with an optional deadline. Copies of a token refer to the same
+     * state, so cancelling one cancels all of them.
+     *
+     * Checking a live token without a deadline is a single relaxed atomic load. Tokens with a
+     * deadline additionally read the steady clock until the deadline passes.
+     */
+    class cancel_token final {
+    private:
+        std::shared_ptr<internal::cancel_state> state;
+
+        explicit cancel_token(std::shared_ptr<internal::cancel_state> state)
+            : state(std::move(state))
+        {
+        }
+
+        bool check_slow(unsigned flags) const noexcept
+        {
+            if (flags & (internal::cancel_requested | internal::cancel_expired)) {
+                return true;
+            }
+            if (std::chrono::steady_clock::now() < state->deadline) {
+                return false;
+            }
+            state->flags.fetch_or(internal::cancel_expired, std::memory_order_relaxed);
+            return true;
+        }
+
+    public:
+        /**
+         * Create a live token without a deadline.
+         */
+        cancel_token() : state(std::make_shared<internal::cancel_state>())
+        {
+        }
+
+        /**
+         * Create a token that expires at `deadline`.
+         *
+         * @param deadline std::chrono::steady_clock::time_point
+         * @return maybe::cancel_token
+         */
+        static cancel_token with_deadline(std::chrono::steady_clock::time_point deadline)
+        {
+            return cancel_token(std::make_shared<internal::cancel_state>(deadline));
+        }
+
+        /**
+         * Create a token that expires after `timeout` from now.
+         *
+         * @param timeout std::chrono::duration
+         * @return maybe::cancel_token
+         */
+        template <typename Rep, typename Period>
+        static cancel_token with_timeout(std::chrono::duration<Rep, Period> timeout)
+        {
+            return with_deadline(
+                std::chrono::steady_clock::now()
+                + std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout));
+        }
+
+        /**
+         * Request cancellation of all work observing this token.
+         */
+        void cancel() const noexcept
+        {
+            state->flags.fetch_or(internal::cancel_requested, std::memory_order_relaxed);
+        }
+
+        /**
+         * Check if cancellation was requested or the deadline has passed.
+         *
+         * @return bool
+         */
+        bool is_cancelled() const noexcept
+        {
+            auto flags = state->flags.load(std::memory_order_relaxed);
+            if (flags == internal::cancel_live) {
+                return false;
+            }
+            return check_slow(flags);
+        }
+
+        /**
+         * Why the token is cancelled. Only meaningful once `is_cancelled()` returned true.
+         *
+         * @return maybe::cancel_reason
+         */
+        cancel_reason reason() const noexcept
+        {
+            return state->flags.load(std::memory_order_relaxed) & internal::cancel_requested
+                ? cancel_reason::cancelled
+                : cancel_reason::deadline_exceeded;
+        }
+    };
+
+    template <typename T, typename E>
+    template <typename F>
+    inline auto result<T, E>::and_then(const cancel_token& token, F f) & noexcept ->
+        typename std::result_of<F(T)>::type
+    {
+        typedef typename std::result_of<F(T)>::type result_t;
+
+        if (MAYBE_RESULT_UNLIKELY(var_err)) {
+            return internal::propagate_err<result_t>(E(*var_err));
+        }
+        if (MAYBE_RESULT_UNLIKELY(token.is_cancelled())) {
+            return result_t(internal::placeholder{}, cancel_error<E>::make(token.reason()));
+        }
+        return f(ok_value());
+    }
+
+    template <typename T, typename E>
+    template <typename F>
+    inline auto result<T, E>::and_then(const cancel_token& token, F f) && noexcept ->
+        typename std::result_of<F(T)>::type
+    {
+        typedef typename std::result_of<F(T)>::type result_t;
+
+        if (MAYBE_RESULT_UNLIKELY(var_err)) {
+            return internal::propagate_err<result_t>(std::move(*var_err));
+        }
+        if (MAYBE_RESULT_UNLIKELY(token.is_cancelled())) {
+            return result_t(internal::placeholder{}, cancel_error<E>::make(token.reason()));
+        }
+        return f(std::move(ok_value()));
+    }
+
+    template <typename E>
+    template <typename F>
+    inline auto result<void, E>::and_then(const cancel_token& token, F f) noexcept ->
+        typename std::result_of<F()>::type
+    {
+        typedef typename std::result_of<F()>::type result_t;
+
+        if (MAYBE_RESULT_UNLIKELY(var_err)) {
+            return internal::propagate_err<result_t>(std::move(*var_err));
+        }
+        if (MAYBE_RESULT_UNLIKELY(token.is_cancelled())) {
+            return result_t(internal::placeholder{}, cancel_error<E>::make(token.reason()));
+        }
+        return f();
+    }
+}
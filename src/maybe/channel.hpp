@@ -0,0 +1,346 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include "atomic_wait.hpp"
+#include "result.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace maybe {
+    namespace internal {
+        inline std::size_t round_up_to_power_of_two(std::size_t value) noexcept
+        {
+            std::size_t out = 1;
+            while (out < value) {
+                out <<= 1;
+            }
+            return out;
+        }
+    }
+
+    template <typename Result>
+    class channel;
+
+    /**
+     * Bounded multi-producer multi-consumer queue of results, based on Dmitry Vyukov's bounded
+     * MPMC queue. Each slot carries a sequence number that tells producers and consumers whether
+     * it is free or filled for the current lap, so that neither side takes a lock.
+     *
+     * `close(e)` stops producers and delivers a copy of the terminal error `e` to every consumer
+     * once the values already queued are drained. A push racing with `close` may still land
+     * after a consumer has seen the terminal error.
+     */
+    template <typename T, typename E>
+    class channel<result<T, E>> final {
+    public:
+        typedef result<T, E> value_type;
+
+    private:
+        enum close_state : unsigned {
+            open = 0,
+            closing = 1,
+            closed = 2,
+        };
+
+        struct cell final {
+            std::atomic<std::size_t> sequence;
+            typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type storage;
+
+            value_type* value() noexcept
+            {
+                return reinterpret_cast<value_type*>(&storage);
+            }
+        };
+
+        const std::size_t mask;
+        std::unique_ptr<cell[]> cells;
+
+        // Producer, consumer and close state get a cache line each, padded explicitly rather
+        // than with alignas: channels are allocated with new, which ignores extended alignment
+        // before C++17.
+        static constexpr std::size_t line_size = 64;
+        typedef std::atomic<std::size_t> position_t;
+        typedef std::atomic<unsigned> counter_t;
+
+        char leading_padding[line_size];
+        position_t enqueue_pos{0};
+        // Bumped after values are published, and by `close`. Blocked consumers park on it.
+        counter_t pushed{0};
+        char enqueue_padding[line_size - sizeof(position_t) - sizeof(counter_t)];
+        position_t dequeue_pos{0};
+        // Bumped after slots are released, and by `close`. Blocked producers park on it.
+        counter_t popped{0};
+        char dequeue_padding[line_size - sizeof(position_t) - sizeof(counter_t)];
+        std::atomic<unsigned> state{open};
+        char state_padding[line_size - sizeof(std::atomic<unsigned>)];
+        std::experimental::optional<E> terminal;
+
+        /**
+         * Claim up to `n` consecutive slots whose sequence is `pos + ready_offset`, which is 0
+         * for free slots claimed by producers and 1 for filled slots claimed by consumers.
+         *
+         * @return first claimed position and number of slots claimed
+         */
+        std::pair<std::size_t, std::size_t> claim(std::atomic<std::size_t>& position,
+                                                  std::size_t ready_offset,
+                                                  std::size_t n) noexcept
+        {
+            auto pos = position.load(std::memory_order_relaxed);
+            for (;;) {
+                std::size_t count = 0;
+                bool retry = false;
+                while (count < n) {
+                    auto& c = cells[(pos + count) & mask];
+                    auto seq = c.sequence.load(std::memory_order_acquire);
+                    auto diff = static_cast<std::ptrdiff_t>(seq - (pos + count + ready_offset));
+                    if (diff == 0) {
+                        ++count;
+                    } else if (diff > 0 && count == 0) {
+                        // Another thread took this slot, start over from the current position.
+                        pos = position.load(std::memory_order_relaxed);
+                        retry = true;
+                        break;
+                    } else {
+                        break;
+                    }
+                }
+                if (retry) {
+                    continue;
+                }
+                if (count == 0) {
+                    return std::make_pair(pos, std::size_t(0));
+                }
+                if (position.compare_exchange_weak(
+                        pos, pos + count, std::memory_order_relaxed, std::memory_order_relaxed)) {
+                    return std::make_pair(pos, count);
+                }
+            }
+        }
+
+        void publish(std::size_t pos, value_type&& value) noexcept
+        {
+            auto& c = cells[pos & mask];
+            ::new (static_cast<void*>(c.value())) value_type(std::move(value));
+            c.sequence.store(pos + 1, std::memory_order_release);
+        }
+
+        value_type consume(std::size_t pos) noexcept
+        {
+            auto& c = cells[pos & mask];
+            value_type out(std::move(*c.value()));
+            c.value()->~value_type();
+            c.sequence.store(pos + mask + 1, std::memory_order_release);
+            return out;
+        }
+
+        static void bump(counter_t& counter) noexcept
+        {
+            counter.fetch_add(1, std::memory_order_release);
+            internal::atomic_notify_all(counter);
+        }
+
+        bool drained() const noexcept
+        {
+            return state.load(std::memory_order_acquire) == closed
+                && dequeue_pos.load(std::memory_order_acquire)
+                == enqueue_pos.load(std::memory_order_acquire);
+        }
+
+    public:
+        /**
+         * Create an empty channel.
+         *
+         * @param capacity minimum number of queued values, rounded up to a power of two
+         */
+        explicit channel(std::size_t capacity)
+            : mask(internal::round_up_to_power_of_two(capacity < 2 ? 2 : capacity) - 1),
+              cells(new cell[mask + 1])
+        {
+            for (std::size_t i = 0; i <= mask; ++i) {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        channel(const channel&) = delete;
+        channel& operator=(const channel&) = delete;
+
+        ~channel()
+        {
+            auto end = enqueue_pos.load(std::memory_order_relaxed);
+            for (auto pos = dequeue_pos.load(std::memory_order_relaxed); pos != end; ++pos) {
+                cells[pos & mask].value()->~value_type();
+            }
+        }
+
+        /**
+         * Number of values the channel can hold.
+         *
+         * @return std::size_t
+         */
+        std::size_t capacity() const noexcept
+        {
+            return mask + 1;
+        }
+
+        /**
+         * Queue a value without blocking.
+         *
+         * @param value maybe::result<T, E>
+         * @return false if the channel is full or closed
+         */
+        bool try_push(value_type&& value) noexcept
+        {
+            return push_n(&value, 1) == 1;
+        }
+
+        /**
+         * Queue a value, waiting for a free slot while the channel is full.
+         *
+         * @param value maybe::result<T, E>
+         * @return false if the channel is closed
+         */
+        bool push(value_type&& value) noexcept
+        {
+            for (;;) {
+                // Read before trying, so that a slot released after the attempt changes it.
+                auto seen = popped.load(std::memory_order_acquire);
+                if (try_push(std::move(value))) {
+                    return true;
+                }
+                if (is_closed()) {
+                    return false;
+                }
+                internal::atomic_wait(popped, seen);
+            }
+        }
+
+        /**
+         * Queue up to `n` values from `first` with a single claim on the producer index. Values
+         * are moved from in order.
+         *
+         * @param first iterator to maybe::result<T, E>
+         * @param n number of values available at `first`
+         * @return number of values queued, zero if the channel is full or closed
+         */
+        template <typename InputIt>
+        std::size_t push_n(InputIt first, std::size_t n) noexcept
+        {
+            if (n == 0 || state.load(std::memory_order_acquire) != open) {
+                return 0;
+            }
+            auto claimed = claim(enqueue_pos, 0, n);
+            for (std::size_t i = 0; i < claimed.second; ++i, ++first) {
+                publish(claimed.first + i, std::move(*first));
+            }
+            if (claimed.second != 0) {
+                bump(pushed);
+            }
+            return claimed.second;
+        }
+
+        /**
+         * Take the next value without blocking.
+         *
+         * @return value, the terminal error once the channel is closed and drained, or nothing
+         *         if the channel is empty
+         */
+        std::experimental::optional<value_type> try_pop() noexcept
+        {
+            std::experimental::optional<value_type> out;
+            if (pop_n(&out, 1) == 0 && drained()) {
+                out.emplace(value_type::err(*terminal));
+            }
+            return out;
+        }
+
+        /**
+         * Take the next value, waiting while the channel is empty.
+         *
+         * @return value, or the terminal error once the channel is closed and drained
+         */
+        value_type pop() noexcept
+        {
+            for (;;) {
+                // Read before trying, so that a value published after the attempt changes it.
+                auto seen = pushed.load(std::memory_order_acquire);
+                auto out = try_pop();
+                if (out) {
+                    return std::move(*out);
+                }
+                internal::atomic_wait(pushed, seen);
+            }
+        }
+
+        /**
+         * Take up to `n` values with a single claim on the consumer index.
+         *
+         * Never delivers the terminal error, use `try_pop` or `pop` once `pop_n` returns zero
+         * on a closed channel.
+         *
+         * @param out iterator assigned maybe::result<T, E> values
+         * @param n maximum number of values to take
+         * @return number of values taken
+         */
+        template <typename OutputIt>
+        std::size_t pop_n(OutputIt out, std::size_t n) noexcept
+        {
+            if (n == 0) {
+                return 0;
+            }
+            auto claimed = claim(dequeue_pos, 1, n);
+            for (std::size_t i = 0; i < claimed.second; ++i, ++out) {
+                *out = consume(claimed.first + i);
+            }
+            if (claimed.second != 0) {
+                bump(popped);
+            }
+            return claimed.second;
+        }
+
+        /**
+         * Stop accepting values. Consumers receive the values already queued, then a copy of
+         * `error` on every further pop. Only the first call has an effect.
+         *
+         * @param error terminal error
+         * @return false if the channel was already closed
+         */
+        bool close(E error)
+        {
+            unsigned expected = open;
+            if (!state.compare_exchange_strong(
+                    expected, closing, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return false;
+            }
+            terminal.emplace(std::move(error));
+            state.store(closed, std::memory_order_release);
+            // Wake blocked producers to fail and blocked consumers to take the terminal error.
+            bump(popped);
+            bump(pushed);
+            return true;
+        }
+
+        /**
+         * Check if the channel was closed.
+         *
+         * @return bool
+         */
+        bool is_closed() const noexcept
+        {
+            return state.load(std::memory_order_acquire) != open;
+        }
+    };
+}
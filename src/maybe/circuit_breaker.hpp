@@ -0,0 +1,334 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include "result.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace maybe {
+    /**
+     * State of a circuit_breaker.
+     */
+    enum class circuit_state {
+        closed,
+        open,
+        half_open,
+    };
+
+    /**
+     * Thresholds of a circuit_breaker.
+     *
+     * The breaker opens once at least `min_calls` calls were recorded within `window` and at
+     * least `failure_ratio` of them failed. It stays open for `open_duration`, then lets up to
+     * `half_open_probes` calls through and closes once that many of them succeed in a row.
+     */
+    struct circuit_breaker_options final {
+        std::chrono::steady_clock::duration window = std::chrono::seconds(10);
+        std::size_t buckets = 10;
+        std::size_t min_calls = 20;
+        double failure_ratio = 0.5;
+        std::chrono::steady_clock::duration open_duration = std::chrono::seconds(5);
+        std::size_t half_open_probes = 1;
+    };
+
+    namespace internal {
+        /**
+         * Ring of time buckets counting successes and failures. Each bucket is a single 64 bit
+         * word holding a 24 bit lap tag and two saturating 20 bit counters, so that recording a
+         * call is one CAS and a stale bucket is reset by the same CAS that counts into it.
+         *
+         * The lap is the number of full windows before the bucket's epoch, which is all that
+         * tells epochs sharing a bucket apart. A stale bucket is only mistaken for a current one
+         * if it went untouched for a multiple of 2^24 windows.
+         */
+        class sliding_window final {
+        private:
+            static constexpr std::uint64_t lap_bits = 24;
+            static constexpr std::uint64_t count_bits = 20;
+            static constexpr std::uint64_t count_max = (std::uint64_t(1) << count_bits) - 1;
+            static constexpr std::uint64_t lap_mask = (std::uint64_t(1) << lap_bits) - 1;
+
+            std::chrono::steady_clock::duration bucket_width;
+            std::size_t count;
+            std::unique_ptr<std::atomic<std::uint64_t>[]> buckets;
+
+            static std::uint64_t pack(std::uint64_t lap,
+                                      std::uint64_t successes,
+                                      std::uint64_t failures) noexcept
+            {
+                return (lap << (2 * count_bits)) | (successes << count_bits) | failures;
+            }
+
+            static std::uint64_t lap_of(std::uint64_t word) noexcept
+            {
+                return word >> (2 * count_bits);
+            }
+
+            static std::uint64_t successes_of(std::uint64_t word) noexcept
+            {
+                return (word >> count_bits) & count_max;
+            }
+
+            static std::uint64_t failures_of(std::uint64_t word) noexcept
+            {
+                return word & count_max;
+            }
+
+            std::uint64_t epoch_at(std::chrono::steady_clock::time_point now) const noexcept
+            {
+                return static_cast<std::uint64_t>(now.time_since_epoch() / bucket_width);
+            }
+
+        public:
+            sliding_window(std::chrono::steady_clock::duration window, std::size_t buckets)
+                : bucket_width(window / static_cast<std::int64_t>(buckets == 0 ? 1 : buckets)),
+                  count(buckets == 0 ? 1 : buckets),
+                  buckets(new std::atomic<std::uint64_t>[count])
+            {
+                if (bucket_width <= std::chrono::steady_clock::duration::zero()) {
+                    bucket_width = std::chrono::steady_clock::duration(1);
+                }
+                reset();
+            }
+
+            void record(bool ok, std::chrono::steady_clock::time_point now) noexcept
+            {
+                auto epoch = epoch_at(now);
+                auto& bucket = buckets[epoch % count];
+                auto tag = (epoch / count) & lap_mask;
+                auto word = bucket.load(std::memory_order_relaxed);
+                for (;;) {
+                    std::uint64_t successes = 0;
+                    std::uint64_t failures = 0;
+                    if (lap_of(word) == tag) {
+                        successes = successes_of(word);
+                        failures = failures_of(word);
+                    }
+                    if (ok) {
+                        successes += successes < count_max;
+                    } else {
+                        failures += failures < count_max;
+                    }
+                    if (bucket.compare_exchange_weak(word,
+                                                     pack(tag, successes, failures),
+                                                     std::memory_order_relaxed,
+                                                     std::memory_order_relaxed)) {
+                        return;
+                    }
+                }
+            }
+
+            /**
+             * Sum the buckets that belong to the window ending at `now`.
+             *
+             * @return successes and failures
+             */
+            std::pair<std::uint64_t, std::uint64_t> totals(
+                std::chrono::steady_clock::time_point now) const noexcept
+            {
+                auto epoch = epoch_at(now);
+                auto lap = epoch / count;
+                auto newest = epoch % count;
+                std::uint64_t successes = 0;
+                std::uint64_t failures = 0;
+                for (std::size_t i = 0; i < count; ++i) {
+                    auto word = buckets[i].load(std::memory_order_relaxed);
+                    // Buckets past the newest one belong to the previous lap.
+                    auto current_lap = (i <= newest ? lap : lap - 1) & lap_mask;
+                    if (lap_of(word) == current_lap) {
+                        successes += successes_of(word);
+                        failures += failures_of(word);
+                    }
+                }
+                return std::make_pair(successes, failures);
+            }
+
+            void reset() noexcept
+            {
+                // Empty buckets count nothing whichever lap they are tagged with.
+                for (std::size_t i = 0; i < count; ++i) {
+                    buckets[i].store(0, std::memory_order_relaxed);
+                }
+            }
+        };
+    }
+
+    /**
+     * Stops calling a failing dependency for a while.
+     *
+     * While closed, calls go through and their outcome is counted in a lock-free sliding
+     * window. Once the failure ratio crosses the threshold the breaker opens and returns the
+     * configured error without calling the dependency. After `open_duration` a limited number of
+     * probe calls are let through, which either close the breaker again or reopen it.
+     *
+     * `Clock` only needs a static `now()` returning `std::chrono::steady_clock::time_point`, so
+     * that tests can control time.
+     */
+    template <typename E, typename Clock = std::chrono::steady_clock>
+    class circuit_breaker final {
+    private:
+        typedef std::chrono::steady_clock::time_point time_point;
+        typedef std::chrono::steady_clock::duration duration;
+
+        /**
+         * Held by `current` while the tripping call publishes `opened_at`. Calls treat it as
+         * open, and `state()` reports it as such.
+         */
+        static constexpr circuit_state tripping = static_cast<circuit_state>(3);
+
+        const E open_error;
+        const circuit_breaker_options options;
+        internal::sliding_window window;
+
+        std::atomic<circuit_state> current{circuit_state::closed};
+        std::atomic<duration::rep> opened_at{0};
+        std::atomic<std::size_t> probes{0};
+        std::atomic<std::size_t> probe_successes{0};
+
+        void trip(circuit_state from, time_point now) noexcept
+        {
+            // Only the call that wins the transition writes the open time, so that a late
+            // failure which lost the race cannot push it back. The open time is published
+            // before the state, so that callers seeing `open` never compare against an older one.
+            if (!current.compare_exchange_strong(
+                    from, tripping, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return;
+            }
+            opened_at.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+            current.store(circuit_state::open, std::memory_order_release);
+        }
+
+        void close() noexcept
+        {
+            auto from = circuit_state::half_open;
+            window.reset();
+            current.compare_exchange_strong(
+                from, circuit_state::closed, std::memory_order_acq_rel, std::memory_order_acquire);
+        }
+
+        bool should_trip(time_point now) const noexcept
+        {
+            auto totals = window.totals(now);
+            auto calls = totals.first + totals.second;
+            return calls >= options.min_calls && calls > 0
+                && static_cast<double>(totals.second) >= options.failure_ratio * calls;
+        }
+
+        /**
+         * Move an open breaker to half-open once `open_duration` has passed.
+         */
+        bool open_elapsed(time_point now) noexcept
+        {
+            auto opened = time_point(duration(opened_at.load(std::memory_order_acquire)));
+            if (now - opened < options.open_duration) {
+                return false;
+            }
+            auto from = circuit_state::open;
+            if (current.compare_exchange_strong(from,
+                                                circuit_state::half_open,
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_acquire)) {
+                probe_successes.store(0, std::memory_order_relaxed);
+                probes.store(0, std::memory_order_release);
+            }
+            return true;
+        }
+
+        template <typename R, typename F>
+        R probe(F& f)
+        {
+            if (probes.fetch_add(1, std::memory_order_acq_rel) >= options.half_open_probes) {
+                probes.fetch_sub(1, std::memory_order_acq_rel);
+                return R::err(open_error);
+            }
+            auto r = f();
+            if (r.is_err()) {
+                trip(circuit_state::half_open, Clock::now());
+            } else if (probe_successes.fetch_add(1, std::memory_order_acq_rel) + 1
+                       >= options.half_open_probes) {
+                close();
+            }
+            // Probe slots are not released, so that at most `half_open_probes` calls reach the
+            // dependency per half-open period.
+            return r;
+        }
+
+    public:
+        /**
+         * @param open_error returned instead of calling the dependency while the breaker is open
+         * @param options thresholds
+         */
+        explicit circuit_breaker(E open_error,
+                                 circuit_breaker_options options = circuit_breaker_options())
+            : open_error(std::move(open_error)),
+              options(options),
+              window(options.window, options.buckets)
+        {
+        }
+
+        circuit_breaker(const circuit_breaker&) = delete;
+        circuit_breaker& operator=(const circuit_breaker&) = delete;
+
+        /**
+         * Call `f` unless the breaker is open.
+         *
+         * @param f F() -> maybe::result<T, E>
+         * @return result of `f`, or the open error
+         */
+        template <typename F, typename R = typename std::result_of<F()>::type>
+        auto call(F&& f) -> R
+        {
+            static_assert(std::is_same<typename R::err_type, E>::value,
+                          "circuit_breaker requires a function returning its err type");
+
+            auto state = current.load(std::memory_order_acquire);
+            if (state == circuit_state::open) {
+                if (!open_elapsed(Clock::now())) {
+                    return R::err(open_error);
+                }
+                state = current.load(std::memory_order_acquire);
+            }
+            if (state == circuit_state::half_open) {
+                return probe<R>(f);
+            }
+            if (state != circuit_state::closed) {
+                return R::err(open_error);
+            }
+
+            auto r = f();
+            auto now = Clock::now();
+            window.record(r.is_ok(), now);
+            if (r.is_err() && should_trip(now)) {
+                trip(circuit_state::closed, now);
+            }
+            return r;
+        }
+
+        /**
+         * Current state. An open breaker whose `open_duration` has passed reports `open` until
+         * the next call moves it to half-open.
+         *
+         * @return maybe::circuit_state
+         */
+        circuit_state state() const noexcept
+        {
+            auto state = current.load(std::memory_order_acquire);
+            return state == tripping ? circuit_state::open : state;
+        }
+    };
+}
@@ -0,0 +1,266 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace maybe {
+    /**
+     * Ordered list of errors that keeps the first `N` errors inline and only allocates once more
+     * than `N` errors are added.
+     */
+    template <typename E, std::size_t N = 2>
+    class error_list final {
+        static_assert(N > 0, "error_list needs room for at least one inline error");
+
+    private:
+        typename std::aligned_storage<sizeof(E), alignof(E)>::type inline_errors[N];
+        std::size_t inline_size = 0;
+        std::vector<E> spilled_errors;
+
+        E* inline_data() noexcept
+        {
+            return reinterpret_cast<E*>(inline_errors);
+        }
+
+        const E* inline_data() const noexcept
+        {
+            return reinterpret_cast<const E*>(inline_errors);
+        }
+
+        template <typename... A>
+        void construct(A&&... args)
+        {
+            if (inline_size < N) {
+                ::new (static_cast<void*>(inline_data() + inline_size)) E(std::forward<A>(args)...);
+                ++inline_size;
+            } else {
+                spilled_errors.emplace_back(std::forward<A>(args)...);
+            }
+        }
+
+        void destroy() noexcept
+        {
+            for (std::size_t i = 0; i < inline_size; ++i) {
+                inline_data()[i].~E();
+            }
+            inline_size = 0;
+            spilled_errors.clear();
+        }
+
+    public:
+        typedef E value_type;
+        typedef const E& const_reference;
+        typedef std::size_t size_type;
+
+        class const_iterator final {
+        private:
+            const error_list* list = nullptr;
+            std::size_t index = 0;
+
+        public:
+            typedef E value_type;
+            typedef const E& reference;
+            typedef const E* pointer;
+            typedef std::ptrdiff_t difference_type;
+            typedef std::forward_iterator_tag iterator_category;
+
+            const_iterator() = default;
+
+            const_iterator(const error_list* list, std::size_t index) : list(list), index(index)
+            {
+            }
+
+            reference operator*() const
+            {
+                return (*list)[index];
+            }
+
+            pointer operator->() const
+            {
+                return &(*list)[index];
+            }
+
+            const_iterator& operator++()
+            {
+                ++index;
+                return *this;
+            }
+
+            const_iterator operator++(int)
+            {
+                auto previous = *this;
+                ++index;
+                return previous;
+            }
+
+            friend bool operator==(const const_iterator& x, const const_iterator& y)
+            {
+                return x.list == y.list && x.index == y.index;
+            }
+
+            friend bool operator!=(const const_iterator& x, const const_iterator& y)
+            {
+                return !(x == y);
+            }
+        };
+
+        error_list() noexcept
+        {
+        }
+
+        error_list(const error_list& other) : spilled_errors(other.spilled_errors)
+        {
+            for (std::size_t i = 0; i < other.inline_size; ++i) {
+                construct(other.inline_data()[i]);
+            }
+        }
+
+        error_list(error_list&& other) noexcept(std::is_nothrow_move_constructible<E>::value)
+            : spilled_errors(std::move(other.spilled_errors))
+        {
+            for (std::size_t i = 0; i < other.inline_size; ++i) {
+                construct(std::move(other.inline_data()[i]));
+            }
+            other.destroy();
+        }
+
+        error_list& operator=(const error_list& other)
+        {
+            if (this != &other) {
+                destroy();
+                for (std::size_t i = 0; i < other.inline_size; ++i) {
+                    construct(other.inline_data()[i]);
+                }
+                spilled_errors = other.spilled_errors;
+            }
+            return *this;
+        }
+
+        error_list& operator=(error_list&& other) noexcept(
+            std::is_nothrow_move_constructible<E>::value)
+        {
+            if (this != &other) {
+                destroy();
+                for (std::size_t i = 0; i < other.inline_size; ++i) {
+                    construct(std::move(other.inline_data()[i]));
+                }
+                spilled_errors = std::move(other.spilled_errors);
+                other.destroy();
+            }
+            return *this;
+        }
+
+        ~error_list()
+        {
+            destroy();
+        }
+
+        /**
+         * Append an error.
+         *
+         * @param E value
+         */
+        void push_back(const E& value)
+        {
+            construct(value);
+        }
+
+        void push_back(E&& value)
+        {
+            construct(std::move(value));
+        }
+
+        /**
+         * Append an error constructed in place from `args`.
+         */
+        template <typename... A>
+        void emplace_back(A&&... args)
+        {
+            construct(std::forward<A>(args)...);
+        }
+
+        /**
+         * Number of errors in the list.
+         *
+         * @return std::size_t
+         */
+        std::size_t size() const noexcept
+        {
+            return inline_size + spilled_errors.size();
+        }
+
+        bool empty() const noexcept
+        {
+            return inline_size == 0;
+        }
+
+        /**
+         * Check if errors did not fit into the inline storage and were moved to the heap.
+         *
+         * @return bool
+         */
+        bool spilled() const noexcept
+        {
+            return !spilled_errors.empty();
+        }
+
+        const E& operator[](std::size_t index) const
+        {
+            return index < N ? inline_data()[index] : spilled_errors[index - N];
+        }
+
+        const E& front() const
+        {
+            return (*this)[0];
+        }
+
+        const E& back() const
+        {
+            return (*this)[size() - 1];
+        }
+
+        const_iterator begin() const noexcept
+        {
+            return const_iterator(this, 0);
+        }
+
+        const_iterator end() const noexcept
+        {
+            return const_iterator(this, size());
+        }
+    };
+
+    template <typename E, std::size_t N>
+    bool operator==(const error_list<E, N>& x, const error_list<E, N>& y)
+    {
+        if (x.size() != y.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            if (!(x[i] == y[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename E, std::size_t N>
+    bool operator!=(const error_list<E, N>& x, const error_list<E, N>& y)
+    {
+        return !(x == y);
+    }
+}
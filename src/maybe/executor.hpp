@@ -0,0 +1,583 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include "async_result.hpp"
+#include "cancel_token.hpp"
+#include "result.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace maybe {
+    class executor;
+
+    namespace internal {
+        /**
+         * Unit of work queued on an executor. `run` is responsible for releasing the task, so
+         * that tasks can live on the heap as well as in caller-owned storage.
+         */
+        class task {
+        public:
+            virtual ~task()
+            {
+            }
+
+            virtual void run() = 0;
+        };
+
+        template <typename F>
+        class heap_task final : public task {
+        private:
+            F f;
+
+        public:
+            explicit heap_task(F&& f) : f(std::move(f))
+            {
+            }
+
+            void run() override
+            {
+                F local(std::move(f));
+                delete this;
+                local();
+            }
+        };
+
+        /**
+         * Chase-Lev work stealing deque of tasks (Lê et al., "Correct and Efficient
+         * Work-Stealing for Weak Memory Models"). The owning worker pushes and takes at the
+         * bottom, other workers steal from the top.
+         */
+        class work_deque final {
+        private:
+            struct ring final {
+                std::int64_t capacity;
+                std::unique_ptr<std::atomic<task*>[]> slots;
+
+                explicit ring(std::int64_t capacity)
+                    : capacity(capacity), slots(new std::atomic<task*>[capacity])
+                {
+                }
+
+                task* get(std::int64_t index) const noexcept
+                {
+                    return slots[index & (capacity - 1)].load(std::memory_order_relaxed);
+                }
+
+                void put(std::int64_t index, task* t) noexcept
+                {
+                    slots[index & (capacity - 1)].store(t, std::memory_order_relaxed);
+                }
+            };
+
+            // top and bottom get a cache line each, padded explicitly rather than with alignas:
+            // deques are allocated with new, which ignores extended alignment before C++17.
+            static constexpr std::size_t line_size = 64;
+            typedef std::atomic<std::int64_t> index_t;
+
+            char leading_padding[line_size];
+            index_t top{0};
+            char top_padding[line_size - sizeof(index_t)];
+            index_t bottom{0};
+            char bottom_padding[line_size - sizeof(index_t)];
+            std::atomic<ring*> buffer;
+            // Rings replaced by `grow` stay alive until the deque is destroyed, because thieves
+            // may still be reading from them.
+            std::vector<std::unique_ptr<ring>> rings;
+
+            ring* grow(ring* old, std::int64_t t, std::int64_t b)
+            {
+                rings.emplace_back(new ring(old->capacity * 2));
+                auto bigger = rings.back().get();
+                for (auto i = t; i < b; ++i) {
+                    bigger->put(i, old->get(i));
+                }
+                buffer.store(bigger, std::memory_order_release);
+                return bigger;
+            }
+
+        public:
+            explicit work_deque(std::int64_t capacity = 256)
+            {
+                rings.emplace_back(new ring(capacity));
+                buffer.store(rings.back().get(), std::memory_order_relaxed);
+            }
+
+            /**
+             * Push a task at the bottom. Owner only.
+             */
+            void push(task* t)
+            {
+                auto b = bottom.load(std::memory_order_relaxed);
+                auto tp = top.load(std::memory_order_acquire);
+                auto r = buffer.load(std::memory_order_relaxed);
+                if (b - tp > r->capacity - 1) {
+                    r = grow(r, tp, b);
+                }
+                r->put(b, t);
+                std::atomic_thread_fence(std::memory_order_release);
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+
+            /**
+             * Take the most recently pushed task. Owner only.
+             *
+             * @return task or nullptr if empty
+             */
+            task* take() noexcept
+            {
+                auto b = bottom.load(std::memory_order_relaxed) - 1;
+                auto r = buffer.load(std::memory_order_relaxed);
+                bottom.store(b, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                auto t = top.load(std::memory_order_relaxed);
+
+                if (t > b) {
+                    bottom.store(b + 1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+
+                auto x = r->get(b);
+                if (t == b) {
+                    if (!top.compare_exchange_strong(
+                            t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                        x = nullptr;
+                    }
+                    bottom.store(b + 1, std::memory_order_relaxed);
+                }
+                return x;
+            }
+
+            /**
+             * Steal the least recently pushed task. Any thread.
+             *
+             * @return task or nullptr if empty or lost a race with another thread
+             */
+            task* steal() noexcept
+            {
+                auto t = top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                auto b = bottom.load(std::memory_order_acquire);
+
+                if (t >= b) {
+                    return nullptr;
+                }
+
+                auto x = buffer.load(std::memory_order_acquire)->get(t);
+                if (!top.compare_exchange_strong(
+                        t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    return nullptr;
+                }
+                return x;
+            }
+
+            bool empty() const noexcept
+            {
+                return top.load(std::memory_order_acquire)
+                    >= bottom.load(std::memory_order_acquire);
+            }
+        };
+
+        struct worker_context final {
+            executor* owner;
+            std::size_t index;
+        };
+
+        struct timer_entry final {
+            std::chrono::steady_clock::time_point deadline;
+            std::uint64_t sequence;
+            task* t;
+
+            bool operator<(const timer_entry& other) const noexcept
+            {
+                // std::priority_queue is a max heap, so the earliest deadline compares greatest.
+                return deadline != other.deadline ? deadline > other.deadline
+                                                  : sequence > other.sequence;
+            }
+        };
+
+        inline worker_context*& current_worker() noexcept
+        {
+            static thread_local worker_context* worker = nullptr;
+            return worker;
+        }
+    }
+
+    /**
+     * Fixed size thread pool with per-worker work stealing deques.
+     *
+     * Work submitted from a worker thread goes to that worker's own deque, work submitted from
+     * other threads goes to a shared injection queue. Idle workers steal from each other before
+     * going to sleep.
+     *
+     * Satisfies the executor interface used by async_result continuations. Tasks must not throw.
+     * The destructor runs all queued work, including work queued by running tasks, before joining
+     * the workers. Delayed tasks that are still pending at that point run without waiting for
+     * their deadline.
+     */
+    class executor final {
+    private:
+        std::vector<std::unique_ptr<internal::work_deque>> deques;
+        std::vector<std::thread> workers;
+
+        std::mutex injected_mutex;
+        std::deque<internal::task*> injected;
+        std::atomic<std::size_t> injected_size{0};
+
+        std::mutex sleep_mutex;
+        std::condition_variable sleep_cv;
+        std::atomic<std::uint64_t> epoch{0};
+        std::atomic<std::size_t> sleepers{0};
+        std::atomic<bool> stopping{false};
+
+        typedef std::chrono::steady_clock::rep tick_t;
+
+        std::mutex timer_mutex;
+        std::priority_queue<internal::timer_entry> timers;
+        std::uint64_t timer_sequence = 0;
+        // Earliest timer deadline in steady_clock ticks, so that workers can skip the timer lock
+        // while nothing is due.
+        std::atomic<tick_t> next_deadline{std::numeric_limits<tick_t>::max()};
+
+        static tick_t ticks(std::chrono::steady_clock::time_point t) noexcept
+        {
+            return t.time_since_epoch().count();
+        }
+
+        static std::chrono::steady_clock::time_point time_point(tick_t t) noexcept
+        {
+            return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(t));
+        }
+
+        bool has_timers() const noexcept
+        {
+            return next_deadline.load(std::memory_order_acquire)
+                != std::numeric_limits<tick_t>::max();
+        }
+
+        /**
+         * Move due timers to the current worker's deque, or all timers once stopping.
+         */
+        void run_due_timers()
+        {
+            auto deadline = next_deadline.load(std::memory_order_acquire);
+            if (deadline == std::numeric_limits<tick_t>::max()) {
+                return;
+            }
+            auto stop = stopping.load(std::memory_order_acquire);
+            auto now = std::chrono::steady_clock::now();
+            if (!stop && ticks(now) < deadline) {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(timer_mutex);
+            while (!timers.empty() && (stop || timers.top().deadline <= now)) {
+                post(timers.top().t);
+                timers.pop();
+            }
+            next_deadline.store(
+                timers.empty() ? std::numeric_limits<tick_t>::max() : ticks(timers.top().deadline),
+                std::memory_order_release);
+        }
+
+        void wake_one()
+        {
+            epoch.fetch_add(1, std::memory_order_seq_cst);
+            if (sleepers.load(std::memory_order_seq_cst) != 0) {
+                std::lock_guard<std::mutex> lock(sleep_mutex);
+                sleep_cv.notify_one();
+            }
+        }
+
+        internal::task* pop_injected()
+        {
+            if (injected_size.load(std::memory_order_acquire) == 0) {
+                return nullptr;
+            }
+            std::lock_guard<std::mutex> lock(injected_mutex);
+            if (injected.empty()) {
+                return nullptr;
+            }
+            auto t = injected.front();
+            injected.pop_front();
+            injected_size.fetch_sub(1, std::memory_order_release);
+            return t;
+        }
+
+        internal::task* find_task(std::size_t self)
+        {
+            if (auto t = deques[self]->take()) {
+                return t;
+            }
+            if (auto t = pop_injected()) {
+                return t;
+            }
+            for (std::size_t i = 1; i < deques.size(); ++i) {
+                if (auto t = deques[(self + i) % deques.size()]->steal()) {
+                    return t;
+                }
+            }
+            return nullptr;
+        }
+
+        bool has_queued_work() const noexcept
+        {
+            if (injected_size.load(std::memory_order_acquire) != 0) {
+                return true;
+            }
+            for (auto& d : deques) {
+                if (!d->empty()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void work(std::size_t self)
+        {
+            internal::worker_context context{this, self};
+            internal::current_worker() = &context;
+
+            for (;;) {
+                auto seen = epoch.load(std::memory_order_seq_cst);
+
+                run_due_timers();
+
+                if (auto t = find_task(self)) {
+                    t->run();
+                    continue;
+                }
+
+                if (has_queued_work()) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                if (stopping.load(std::memory_order_acquire)) {
+                    if (has_timers()) {
+                        continue;
+                    }
+                    break;
+                }
+
+                std::unique_lock<std::mutex> lock(sleep_mutex);
+                sleepers.fetch_add(1, std::memory_order_seq_cst);
+                while (epoch.load(std::memory_order_seq_cst) == seen
+                       && !stopping.load(std::memory_order_acquire)) {
+                    auto deadline = next_deadline.load(std::memory_order_acquire);
+                    if (deadline == std::numeric_limits<tick_t>::max()) {
+                        sleep_cv.wait(lock);
+                    } else if (sleep_cv.wait_until(lock, time_point(deadline))
+                               == std::cv_status::timeout) {
+                        break;
+                    }
+                }
+                sleepers.fetch_sub(1, std::memory_order_seq_cst);
+            }
+
+            internal::current_worker() = nullptr;
+        }
+
+    public:
+        /**
+         * Start the worker threads.
+         *
+         * @param threads number of workers, `std::thread::hardware_concurrency()` if zero
+         */
+        explicit executor(std::size_t threads = 0)
+        {
+            if (threads == 0) {
+                threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+            }
+            for (std::size_t i = 0; i < threads; ++i) {
+                deques.emplace_back(new internal::work_deque());
+            }
+            workers.reserve(threads);
+            for (std::size_t i = 0; i < threads; ++i) {
+                workers.emplace_back([this, i]() { work(i); });
+            }
+        }
+
+        executor(const executor&) = delete;
+        executor& operator=(const executor&) = delete;
+
+        ~executor()
+        {
+            stopping.store(true, std::memory_order_release);
+            epoch.fetch_add(1, std::memory_order_seq_cst);
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex);
+                sleep_cv.notify_all();
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+
+        /**
+         * Number of worker threads.
+         *
+         * @return std::size_t
+         */
+        std::size_t size() const noexcept
+        {
+            return workers.size();
+        }
+
+        /**
+         * Run one queued task on the calling thread. Lets a thread that waits for work queued on
+         * this executor help with it instead of blocking, which would deadlock a worker waiting
+         * for its own children.
+         *
+         * @return false if no task was queued
+         */
+        bool try_run_one()
+        {
+            internal::task* t = nullptr;
+            auto worker = internal::current_worker();
+            if (worker != nullptr && worker->owner == this) {
+                t = find_task(worker->index);
+            } else {
+                t = pop_injected();
+                for (std::size_t i = 0; t == nullptr && i < deques.size(); ++i) {
+                    t = deques[i]->steal();
+                }
+            }
+            if (t == nullptr) {
+                return false;
+            }
+            t->run();
+            return true;
+        }
+
+        /**
+         * Check if the calling thread is one of this executor's workers.
+         *
+         * @return bool
+         */
+        bool in_worker() const noexcept
+        {
+            auto worker = internal::current_worker();
+            return worker != nullptr && worker->owner == this;
+        }
+
+        /**
+         * Queue a task. Ownership stays with the task, which releases itself in `run`.
+         *
+         * @param t task
+         */
+        void post(internal::task* t)
+        {
+            auto worker = internal::current_worker();
+            if (worker != nullptr && worker->owner == this) {
+                deques[worker->index]->push(t);
+            } else {
+                std::lock_guard<std::mutex> lock(injected_mutex);
+                injected.push_back(t);
+                injected_size.fetch_add(1, std::memory_order_release);
+            }
+            wake_one();
+        }
+
+        /**
+         * Run `f` on a worker thread.
+         *
+         * @param f F()
+         */
+        template <typename F>
+        void execute(F&& f)
+        {
+            typedef typename std::decay<F>::type callable_t;
+            post(new internal::heap_task<callable_t>(callable_t(std::forward<F>(f))));
+        }
+
+        /**
+         * Run `f` on a worker thread once `delay` has passed, without blocking a worker until
+         * then.
+         *
+         * @param delay std::chrono::duration
+         * @param f F()
+         */
+        template <typename Rep, typename Period, typename F>
+        void execute_after(std::chrono::duration<Rep, Period> delay, F&& f)
+        {
+            typedef typename std::decay<F>::type callable_t;
+            auto t = new internal::heap_task<callable_t>(callable_t(std::forward<F>(f)));
+            auto deadline = std::chrono::steady_clock::now()
+                + std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay);
+            {
+                std::lock_guard<std::mutex> lock(timer_mutex);
+                timers.push(internal::timer_entry{deadline, timer_sequence++, t});
+                next_deadline.store(ticks(timers.top().deadline), std::memory_order_release);
+            }
+            wake_one();
+        }
+
+        /**
+         * Run a result returning function on a worker thread.
+         *
+         * @param f F() -> maybe::result<T, E>
+         * @return maybe::async_result<T, E>
+         */
+        template <typename F, typename R = typename std::result_of<F()>::type>
+        auto submit(F f) -> async_result<typename R::ok_type, typename R::err_type>
+        {
+            async_promise<typename R::ok_type, typename R::err_type> promise;
+            auto out = promise.get_async_result();
+            execute([f = std::move(f), promise = std::move(promise)]() mutable {
+                promise.set(f());
+            });
+            return out;
+        }
+
+        /**
+         * Run a result returning function on a worker thread, unless the token is cancelled by
+         * the time the task starts. A cancelled task resolves with an err value converted from
+         * the cancel reason with `maybe::cancel_error<E>`.
+         *
+         * @param token maybe::cancel_token
+         * @param f F() -> maybe::result<T, E>
+         * @return maybe::async_result<T, E>
+         */
+        template <typename F, typename R = typename std::result_of<F()>::type>
+        auto submit(cancel_token token, F f)
+            -> async_result<typename R::ok_type, typename R::err_type>
+        {
+            async_promise<typename R::ok_type, typename R::err_type> promise;
+            auto out = promise.get_async_result();
+            execute([token = std::move(token), f = std::move(f), promise = std::move(promise)]()
+                        mutable {
+                            if (token.is_cancelled()) {
+                                promise.set(R(internal::placeholder{},
+                                              cancel_error<typename R::err_type>::make(
+                                                  token.reason())));
+                                return;
+                            }
+                            promise.set(f());
+                        });
+            return out;
+        }
+    };
+}
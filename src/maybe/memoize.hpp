@@ -0,0 +1,356 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include "atomic_result.hpp"
+#include "result.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace maybe {
+    /**
+     * Cache limits for `maybe::memoize`. Err entries get their own capacity and a short TTL by
+     * default, so that transient errors are retried instead of being served forever.
+     */
+    struct memoize_policy final {
+        std::size_t err_capacity = 256;
+        std::chrono::steady_clock::duration ok_ttl = std::chrono::steady_clock::duration::max();
+        std::chrono::steady_clock::duration err_ttl = std::chrono::seconds(1);
+        std::size_t shards = 16;
+    };
+
+    /**
+     * Counters of a memoized function, summed over all shards.
+     */
+    struct memoize_stats final {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t coalesced = 0;
+        std::uint64_t evictions = 0;
+        std::uint64_t expirations = 0;
+    };
+
+    namespace internal {
+        inline void hash_combine(std::size_t& seed, std::size_t value) noexcept
+        {
+            seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+        }
+
+        template <typename Tuple>
+        struct tuple_hash final {
+            template <std::size_t... I>
+            static std::size_t hash(const Tuple& key, std::index_sequence<I...>)
+            {
+                std::size_t seed = 0;
+                using expand = int[];
+                (void)expand{0,
+                             (hash_combine(seed,
+                                           std::hash<typename std::tuple_element<I, Tuple>::type>()(
+                                               std::get<I>(key))),
+                              0)...};
+                return seed;
+            }
+
+            std::size_t operator()(const Tuple& key) const
+            {
+                return hash(key, std::make_index_sequence<std::tuple_size<Tuple>::value>{});
+            }
+        };
+
+        template <typename Key, typename T, typename E>
+        class memoize_shard final {
+        private:
+            typedef std::chrono::steady_clock clock;
+            typedef std::list<Key> lru_list;
+
+            struct entry final {
+                result<T, E> value;
+                clock::time_point expires;
+                typename lru_list::iterator position;
+            };
+
+            lru_list ok_lru;
+            lru_list err_lru;
+            std::unordered_map<Key, entry, tuple_hash<Key>> entries;
+
+            lru_list& lru_of(const result<T, E>& value) noexcept
+            {
+                return value.is_ok() ? ok_lru : err_lru;
+            }
+
+            void erase(typename std::unordered_map<Key, entry, tuple_hash<Key>>::iterator it)
+            {
+                lru_of(it->second.value).erase(it->second.position);
+                entries.erase(it);
+            }
+
+        public:
+            std::mutex mutex;
+            std::unordered_map<Key, std::shared_ptr<atomic_result<T, E>>, tuple_hash<Key>>
+                in_flight;
+            memoize_stats stats;
+
+            /**
+             * Find a live entry and mark it as most recently used. Caller holds `mutex`.
+             */
+            const result<T, E>* find(const Key& key, clock::time_point now)
+            {
+                auto it = entries.find(key);
+                if (it == entries.end()) {
+                    return nullptr;
+                }
+                if (it->second.expires <= now) {
+                    erase(it);
+                    ++stats.expirations;
+                    return nullptr;
+                }
+                auto& lru = lru_of(it->second.value);
+                lru.splice(lru.begin(), lru, it->second.position);
+                return &it->second.value;
+            }
+
+            /**
+             * Insert an entry, evicting the least recently used entry of the same kind if the
+             * shard is full. Caller holds `mutex`.
+             */
+            void insert(const Key& key,
+                        const result<T, E>& value,
+                        clock::time_point expires,
+                        std::size_t capacity)
+            {
+                if (capacity == 0) {
+                    return;
+                }
+                auto& lru = lru_of(value);
+                if (lru.size() >= capacity) {
+                    erase(entries.find(lru.back()));
+                    ++stats.evictions;
+                }
+                lru.push_front(key);
+                entries.emplace(key, entry{value, expires, lru.begin()});
+            }
+
+            /**
+             * Remove the in-flight call for `key` without a result. Its waiters are woken with a
+             * result that is neither ok nor err, and call the function themselves.
+             */
+            void abandon(const Key& key)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = in_flight.find(key);
+                it->second->set(result<T, E>());
+                in_flight.erase(it);
+            }
+        };
+
+        /**
+         * Abandons the in-flight call of a memoized function unless released, so that waiters
+         * are not left blocked when the function throws.
+         */
+        template <typename Shard, typename Key>
+        class in_flight_guard final {
+        private:
+            Shard* shard;
+            const Key& key;
+
+        public:
+            in_flight_guard(Shard& shard, const Key& key) : shard(&shard), key(key)
+            {
+            }
+
+            in_flight_guard(const in_flight_guard&) = delete;
+            in_flight_guard& operator=(const in_flight_guard&) = delete;
+
+            ~in_flight_guard()
+            {
+                if (shard != nullptr) {
+                    shard->abandon(key);
+                }
+            }
+
+            void release() noexcept
+            {
+                shard = nullptr;
+            }
+        };
+
+        template <typename F, typename Key, typename T, typename E>
+        struct memoize_state final {
+            F f;
+            std::size_t ok_capacity;
+            std::size_t err_capacity;
+            std::chrono::steady_clock::duration ok_ttl;
+            std::chrono::steady_clock::duration err_ttl;
+            std::size_t shard_mask;
+            std::unique_ptr<memoize_shard<Key, T, E>[]> shards;
+
+            memoize_state(F f, std::size_t capacity, const memoize_policy& policy)
+                : f(std::move(f)),
+                  ok_capacity(0),
+                  err_capacity(0),
+                  ok_ttl(policy.ok_ttl),
+                  err_ttl(policy.err_ttl),
+                  shard_mask(0)
+            {
+                std::size_t count = 1;
+                while (count < policy.shards) {
+                    count <<= 1;
+                }
+                ok_capacity = (capacity + count - 1) / count;
+                err_capacity = (policy.err_capacity + count - 1) / count;
+                shard_mask = count - 1;
+                shards.reset(new memoize_shard<Key, T, E>[count]);
+            }
+        };
+
+        inline std::chrono::steady_clock::time_point saturating_add(
+            std::chrono::steady_clock::time_point now, std::chrono::steady_clock::duration ttl)
+        {
+            return ttl >= std::chrono::steady_clock::time_point::max() - now
+                ? std::chrono::steady_clock::time_point::max()
+                : now + ttl;
+        }
+    }
+
+    /**
+     * Function object returned by `maybe::memoize`. Copies share the same cache.
+     */
+    template <typename F, typename T, typename E, typename... Args>
+    class memoized final {
+    private:
+        typedef std::tuple<typename std::decay<Args>::type...> key_type;
+        typedef internal::memoize_state<F, key_type, T, E> state_type;
+
+        std::shared_ptr<state_type> state;
+
+    public:
+        memoized(F f, std::size_t capacity, const memoize_policy& policy)
+            : state(std::make_shared<state_type>(std::move(f), capacity, policy))
+        {
+        }
+
+        /**
+         * Return the cached result for `args`, or call the wrapped function. Concurrent misses
+         * for the same arguments call the function once and share its result. If that call
+         * throws, the exception propagates to its caller and the waiting callers retry.
+         *
+         * @param args arguments of the wrapped function
+         * @return maybe::result<T, E>
+         */
+        result<T, E> operator()(const typename std::decay<Args>::type&... args) const
+        {
+            key_type key(args...);
+            auto& shard
+                = state->shards[internal::tuple_hash<key_type>()(key) & state->shard_mask];
+            auto now = std::chrono::steady_clock::now();
+
+            std::shared_ptr<atomic_result<T, E>> flight;
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                if (auto cached = shard.find(key, now)) {
+                    ++shard.stats.hits;
+                    return *cached;
+                }
+                auto it = shard.in_flight.find(key);
+                if (it != shard.in_flight.end()) {
+                    ++shard.stats.coalesced;
+                    flight = it->second;
+                } else {
+                    ++shard.stats.misses;
+                    shard.in_flight.emplace(key, std::make_shared<atomic_result<T, E>>());
+                }
+            }
+
+            if (flight) {
+                auto& shared = flight->wait();
+                if (shared.is_ok() || shared.is_err()) {
+                    return shared;
+                }
+                return (*this)(args...);
+            }
+
+            internal::in_flight_guard<internal::memoize_shard<key_type, T, E>, key_type> guard(
+                shard, key);
+            auto value = state->f(args...);
+            guard.release();
+            auto done = std::chrono::steady_clock::now();
+
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.in_flight.find(key);
+            it->second->set(value);
+            shard.in_flight.erase(it);
+            if (value.is_ok()) {
+                shard.insert(
+                    key, value, internal::saturating_add(done, state->ok_ttl), state->ok_capacity);
+            } else {
+                shard.insert(key,
+                             value,
+                             internal::saturating_add(done, state->err_ttl),
+                             state->err_capacity);
+            }
+            return value;
+        }
+
+        /**
+         * Sum the counters of all shards.
+         *
+         * @return maybe::memoize_stats
+         */
+        memoize_stats stats() const
+        {
+            memoize_stats out;
+            for (std::size_t i = 0; i <= state->shard_mask; ++i) {
+                auto& shard = state->shards[i];
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                out.hits += shard.stats.hits;
+                out.misses += shard.stats.misses;
+                out.coalesced += shard.stats.coalesced;
+                out.evictions += shard.stats.evictions;
+                out.expirations += shard.stats.expirations;
+            }
+            return out;
+        }
+    };
+
+    /**
+     * Wrap a result returning function in a sharded concurrent cache keyed on its arguments.
+     *
+     * The argument types are given explicitly, e.g. `maybe::memoize<int>(lookup, 1000)`. They
+     * must be copyable, equality comparable and hashable with `std::hash`. Ok and err results
+     * are evicted separately, least recently used first, and expire after their own TTL.
+     *
+     * `f` is called concurrently for different arguments. If it throws, nothing is cached.
+     *
+     * @param f F(Args...) -> maybe::result<T, E>
+     * @param capacity maximum number of cached ok results
+     * @param policy err capacity, TTLs and shard count
+     * @return maybe::memoized
+     */
+    template <typename... Args,
+              typename F,
+              typename R = typename std::result_of<F(const typename std::decay<Args>::type&...)>::type>
+    auto memoize(F f, std::size_t capacity, const memoize_policy& policy = memoize_policy())
+        -> memoized<F, typename R::ok_type, typename R::err_type, Args...>
+    {
+        return memoized<F, typename R::ok_type, typename R::err_type, Args...>(
+            std::move(f), capacity, policy);
+    }
+}
@@ -0,0 +1,282 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include "executor.hpp"
+#include "result.hpp"
+#include "task_group.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace maybe {
+    namespace parallel {
+        /**
+         * Tuning knobs for parallel algorithms.
+         */
+        struct options final {
+            /**
+             * Maximum number of threads to use, including the calling one. Zero means
+             * `std::thread::hardware_concurrency()`, or one per executor worker plus the calling
+             * thread when reducing on an executor.
+             */
+            std::size_t threads = 0;
+
+            /**
+             * Number of elements processed between checks of the shared cancel flag. Ranges
+             * shorter than two grains are reduced on the calling thread.
+             */
+            std::size_t grain = 4096;
+        };
+
+        namespace internal {
+            constexpr std::size_t no_error = std::numeric_limits<std::size_t>::max();
+
+            template <typename R>
+            struct partial final {
+                R value;
+                std::size_t error_index = no_error;
+            };
+
+            inline void lower_error_index(std::atomic<std::size_t>& first_error, std::size_t index)
+            {
+                auto current = first_error.load(std::memory_order_relaxed);
+                while (index < current
+                       && !first_error.compare_exchange_weak(
+                              current, index, std::memory_order_relaxed)) {
+                }
+            }
+
+            /**
+             * Folds [begin, end) into `acc`, checking `first_error` before each grain so that
+             * work past an already failed element is abandoned.
+             */
+            template <typename R, typename It, typename Acc, typename F>
+            void fold_slice(partial<R>& out,
+                            It begin,
+                            std::size_t begin_index,
+                            std::size_t end_index,
+                            Acc acc,
+                            F& combine,
+                            std::size_t grain,
+                            std::atomic<std::size_t>& first_error)
+            {
+                auto it = begin;
+                auto index = begin_index;
+
+                while (index < end_index) {
+                    if (first_error.load(std::memory_order_relaxed) < index) {
+                        return;
+                    }
+
+                    auto block_end = std::min(end_index, index + grain);
+                    for (; index < block_end; ++index, ++it) {
+                        auto step = combine(std::move(acc), *it);
+                        if (step.is_err()) {
+                            out.value = std::move(step);
+                            out.error_index = index;
+                            lower_error_index(first_error, index);
+                            return;
+                        }
+                        acc = std::move(step.ok_value());
+                    }
+                }
+
+                out.value = R::ok(std::move(acc));
+            }
+
+            /**
+             * Folds slices on threads started for the call.
+             */
+            struct thread_runner final {
+                template <typename G>
+                void run(std::size_t slices, G& slice) const
+                {
+                    std::vector<std::thread> workers;
+                    workers.reserve(slices - 1);
+                    for (std::size_t i = 1; i < slices; ++i) {
+                        workers.emplace_back([&slice, i]() { slice(i); });
+                    }
+                    slice(0);
+                    for (auto& worker : workers) {
+                        worker.join();
+                    }
+                }
+            };
+
+            /**
+             * Folds slices as tasks on an executor. A worker thread that calls in runs queued
+             * tasks while it waits, so nested reductions neither start threads nor deadlock.
+             */
+            template <typename E>
+            struct executor_runner final {
+                maybe::executor& executor;
+
+                template <typename G>
+                void run(std::size_t slices, G& slice) const
+                {
+                    task_group<E> group(executor);
+                    for (std::size_t i = 1; i < slices; ++i) {
+                        group.spawn([&slice, i]() {
+                            slice(i);
+                            return maybe::result<void, E>::ok();
+                        });
+                    }
+                    slice(0);
+                    group.wait();
+                }
+            };
+
+            template <typename R, typename Runner, typename Range, typename Acc, typename F>
+            R reduce_on(const Runner& runner,
+                        const Range& range,
+                        Acc init,
+                        F& combine,
+                        std::size_t grain,
+                        std::size_t threads)
+            {
+                static_assert(std::is_same<typename R::ok_type, Acc>::value,
+                              "combine must return maybe::result<Acc, E>");
+
+                auto first = std::begin(range);
+                auto size = static_cast<std::size_t>(std::distance(first, std::end(range)));
+                grain = std::max<std::size_t>(grain, 1);
+                threads = std::max<std::size_t>(1, std::min<std::size_t>(threads, size / grain));
+
+                std::atomic<std::size_t> first_error(no_error);
+
+                if (threads == 1) {
+                    partial<R> out;
+                    fold_slice(out, first, 0, size, std::move(init), combine, grain, first_error);
+                    return std::move(out.value);
+                }
+
+                std::vector<partial<R>> partials(threads);
+
+                auto slice_begin = [size, threads](std::size_t slice) {
+                    return size * slice / threads;
+                };
+                auto fold = [&](std::size_t slice) {
+                    if (slice == 0) {
+                        fold_slice(partials[0],
+                                   first,
+                                   0,
+                                   slice_begin(1),
+                                   std::move(init),
+                                   combine,
+                                   grain,
+                                   first_error);
+                        return;
+                    }
+                    auto begin_index = slice_begin(slice);
+                    auto it = first;
+                    std::advance(it, begin_index);
+                    fold_slice(partials[slice],
+                               std::next(it),
+                               begin_index + 1,
+                               slice_begin(slice + 1),
+                               Acc(*it),
+                               combine,
+                               grain,
+                               first_error);
+                };
+                runner.run(threads, fold);
+
+                auto failed = std::min_element(
+                    partials.begin(),
+                    partials.end(),
+                    [](const partial<R>& a, const partial<R>& b) {
+                        return a.error_index < b.error_index;
+                    });
+                if (failed->error_index != no_error) {
+                    return std::move(failed->value);
+                }
+
+                for (std::size_t stride = 1; stride < threads; stride *= 2) {
+                    for (std::size_t left = 0; left + stride < threads; left += stride * 2) {
+                        auto& a = partials[left].value;
+                        auto& b = partials[left + stride].value;
+                        a = combine(std::move(a.ok_value()), std::move(b.ok_value()));
+                        if (a.is_err()) {
+                            return std::move(a);
+                        }
+                    }
+                }
+
+                return std::move(partials[0].value);
+            }
+        }
+
+        /**
+         * Reduces a random access range with a fallible, associative `combine` operation.
+         *
+         * The range is split into one contiguous slice per thread. Every slice is folded
+         * independently (the first one starting from `init`, the rest from their first element),
+         * and the partial accumulators are then combined pairwise in a tree, preserving element
+         * order. `combine` therefore needs to be associative, but not commutative.
+         *
+         * When `combine` fails, the error of the element with the lowest index is returned. Slices
+         * past the failed element stop at their next grain boundary.
+         *
+         * Every call starts its own threads, and nested calls start threads per call. Use the
+         * overload taking a `maybe::executor` to share a fixed set of threads.
+         *
+         * @param range random access range of values convertible to Acc
+         * @param init initial accumulator value
+         * @param combine F(Acc, Acc) -> maybe::result<Acc, E>
+         * @return maybe::result<Acc, E>
+         */
+        template <typename Range,
+                  typename Acc,
+                  typename F,
+                  typename R = typename std::result_of<F(Acc, Acc)>::type>
+        auto reduce(const Range& range, Acc init, F combine, options opts = options{}) -> R
+        {
+            auto threads = opts.threads != 0 ? opts.threads : std::thread::hardware_concurrency();
+            return internal::reduce_on<R>(
+                internal::thread_runner{}, range, std::move(init), combine, opts.grain, threads);
+        }
+
+        /**
+         * Same as `reduce`, but folds the slices other than the first as tasks on `executor`
+         * instead of starting threads. With `opts.threads` at zero, the range is split into one
+         * slice per worker plus one for the calling thread.
+         *
+         * @param executor runs the slices
+         * @param range random access range of values convertible to Acc
+         * @param init initial accumulator value
+         * @param combine F(Acc, Acc) -> maybe::result<Acc, E>
+         * @return maybe::result<Acc, E>
+         */
+        template <typename Range,
+                  typename Acc,
+                  typename F,
+                  typename R = typename std::result_of<F(Acc, Acc)>::type>
+        auto reduce(maybe::executor& executor,
+                    const Range& range,
+                    Acc init,
+                    F combine,
+                    options opts = options{}) -> R
+        {
+            typedef internal::executor_runner<typename R::err_type> runner_t;
+
+            auto threads = opts.threads != 0 ? opts.threads : executor.size() + 1;
+            return internal::reduce_on<R>(
+                runner_t{executor}, range, std::move(init), combine, opts.grain, threads);
+        }
+    }
+}
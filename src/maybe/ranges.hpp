@@ -0,0 +1,506 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include "result.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#if defined(__has_include)
+#if __cplusplus > 201703L && __has_include(<ranges>)
+#include <ranges>
+#endif
+#endif
+
+namespace maybe {
+    template <typename Range, typename Adaptor>
+    class result_view;
+
+    namespace internal {
+#if defined(__cpp_lib_ranges)
+        struct view_base : std::ranges::view_base {
+        };
+#else
+        struct view_base {
+        };
+#endif
+
+        template <typename Range>
+        using iterator_t = decltype(std::begin(std::declval<Range&>()));
+
+        template <typename Range>
+        using sentinel_t = decltype(std::end(std::declval<Range&>()));
+
+        /**
+         * Owns an rvalue range, so that temporaries can be piped into adaptors.
+         */
+        template <typename Range>
+        class range_ref final {
+        private:
+            Range range;
+
+        public:
+            explicit range_ref(Range&& range) : range(std::move(range))
+            {
+            }
+
+            Range& get() noexcept
+            {
+                return range;
+            }
+        };
+
+        /**
+         * Refers to an lvalue range without copying it.
+         */
+        template <typename Range>
+        class range_ref<Range&> final {
+        private:
+            Range* range;
+
+        public:
+            explicit range_ref(Range& range) : range(&range)
+            {
+            }
+
+            Range& get() const noexcept
+            {
+                return *range;
+            }
+        };
+
+        /**
+         * Keeps the element under an iterator whose dereference yields a prvalue, so that an
+         * adaptor can inspect and then hand out the same element without recomputing it.
+         * Iterators yielding lvalues are dereferenced directly.
+         */
+        template <typename It,
+                  bool = std::is_lvalue_reference<decltype(*std::declval<const It&>())>::value>
+        class element_cache final {
+        public:
+            typedef decltype(*std::declval<const It&>()) reference;
+
+            reference get(const It& it) const
+            {
+                return *it;
+            }
+
+            void reset() noexcept
+            {
+            }
+        };
+
+        template <typename It>
+        class element_cache<It, false> final {
+        private:
+            typedef std::decay_t<decltype(*std::declval<const It&>())> value_type;
+
+            mutable std::experimental::optional<value_type> cached;
+
+        public:
+            typedef value_type& reference;
+
+            reference get(const It& it) const
+            {
+                if (!cached) {
+                    cached.emplace(*it);
+                }
+                return *cached;
+            }
+
+            void reset() noexcept
+            {
+                cached = std::experimental::nullopt;
+            }
+        };
+
+        /**
+         * Wraps a callable so that adaptors stay assignable even when the callable (e.g. a lambda)
+         * is not.
+         */
+        template <typename F>
+        class callable_box final {
+        private:
+            std::experimental::optional<F> f;
+
+        public:
+            explicit callable_box(F f) : f(std::move(f))
+            {
+            }
+
+            callable_box(const callable_box&) = default;
+            callable_box(callable_box&&) = default;
+
+            callable_box& operator=(const callable_box& other)
+            {
+                if (this != &other) {
+                    f = std::experimental::nullopt;
+                    if (other.f) {
+                        f.emplace(*other.f);
+                    }
+                }
+                return *this;
+            }
+
+            callable_box& operator=(callable_box&& other)
+            {
+                if (this != &other) {
+                    f = std::experimental::nullopt;
+                    if (other.f) {
+                        f.emplace(std::move(*other.f));
+                    }
+                }
+                return *this;
+            }
+
+            template <typename... A>
+            auto operator()(A&&... args) -> decltype(std::declval<F&>()(std::forward<A>(args)...))
+            {
+                return (*f)(std::forward<A>(args)...);
+            }
+        };
+
+        template <typename F>
+        struct transform_ok_adaptor final {
+            callable_box<F> f;
+
+            template <typename Result>
+            constexpr bool skip(const Result&) const noexcept
+            {
+                return false;
+            }
+
+            template <typename Result>
+            constexpr bool stop(const Result&) const noexcept
+            {
+                return false;
+            }
+
+            template <typename Result,
+                      typename U = std::decay_t<decltype(
+                          std::declval<F&>()(std::declval<Result&>().ok_value()))>>
+            auto apply(Result& value)
+                -> maybe::result<U, typename std::decay_t<Result>::err_type>
+            {
+                typedef maybe::result<U, typename std::decay_t<Result>::err_type> return_result_t;
+
+                if (value.is_err()) {
+                    return return_result_t::err(value.err_value());
+                }
+                return return_result_t::ok(f(value.ok_value()));
+            }
+        };
+
+        template <typename F>
+        struct and_then_each_adaptor final {
+            callable_box<F> f;
+
+            template <typename Result>
+            constexpr bool skip(const Result&) const noexcept
+            {
+                return false;
+            }
+
+            template <typename Result>
+            constexpr bool stop(const Result&) const noexcept
+            {
+                return false;
+            }
+
+            template <typename Result>
+            auto apply(Result& value) -> decltype(f(value.ok_value()))
+            {
+                typedef decltype(f(value.ok_value())) result_t;
+
+                if (value.is_err()) {
+                    return maybe::result<typename result_t::ok_type,
+                                         typename result_t::err_type>::err(value.err_value());
+                }
+                return f(value.ok_value());
+            }
+        };
+
+        struct filter_ok_adaptor final {
+            template <typename Result>
+            bool skip(const Result& value) const noexcept
+            {
+                return value.is_err();
+            }
+
+            template <typename Result>
+            constexpr bool stop(const Result&) const noexcept
+            {
+                return false;
+            }
+
+            template <typename Result>
+            auto apply(Result& value) const -> decltype(value.ok_value())
+            {
+                return value.ok_value();
+            }
+        };
+
+        struct take_while_ok_adaptor final {
+            template <typename Result>
+            constexpr bool skip(const Result&) const noexcept
+            {
+                return false;
+            }
+
+            template <typename Result>
+            bool stop(const Result& value) const noexcept
+            {
+                return value.is_err();
+            }
+
+            template <typename Result>
+            auto apply(Result& value) const -> decltype(value.ok_value())
+            {
+                return value.ok_value();
+            }
+        };
+
+        struct errors_adaptor final {
+            template <typename Result>
+            bool skip(const Result& value) const noexcept
+            {
+                return value.is_ok();
+            }
+
+            template <typename Result>
+            constexpr bool stop(const Result&) const noexcept
+            {
+                return false;
+            }
+
+            template <typename Result>
+            auto apply(Result& value) const -> decltype(value.err_value())
+            {
+                return value.err_value();
+            }
+        };
+
+        template <typename Adaptor>
+        struct adaptor_closure final {
+            Adaptor adaptor;
+
+            template <typename Range>
+            friend auto operator|(Range&& range, adaptor_closure closure)
+                -> result_view<Range, Adaptor>
+            {
+                return result_view<Range, Adaptor>(std::forward<Range>(range),
+                                                   std::move(closure.adaptor));
+            }
+        };
+    }
+
+    /**
+     * Lazy, single pass view over a range of results.
+     *
+     * Elements are pulled from the underlying range one at a time as the view is iterated, so no
+     * intermediate containers are allocated between stages. Lvalue ranges are referenced,
+     * rvalue ranges (including other views) are moved into the view.
+     *
+     * Views are created by the adaptors below, either called directly or piped:
+     *
+     *     for (auto& name : load_all() | maybe::transform_ok(parse) | maybe::filter_ok()) { }
+     *
+     * Under C++20 the views model `std::ranges::view` and compose with the standard adaptors.
+     */
+    template <typename Range, typename Adaptor>
+    class result_view final : public internal::view_base {
+    private:
+        typedef internal::iterator_t<Range> base_iterator;
+        typedef internal::sentinel_t<Range> base_sentinel;
+        typedef internal::element_cache<base_iterator> cache_type;
+
+        internal::range_ref<Range> base;
+        Adaptor adaptor;
+
+    public:
+        class iterator final {
+        private:
+            result_view* parent = nullptr;
+            base_iterator current{};
+            base_sentinel last{};
+            cache_type cache;
+            bool done = true;
+
+            void settle()
+            {
+                for (; !(current == last); cache.reset(), ++current) {
+                    auto& value = cache.get(current);
+                    if (parent->adaptor.stop(value)) {
+                        break;
+                    }
+                    if (!parent->adaptor.skip(value)) {
+                        done = false;
+                        return;
+                    }
+                }
+                done = true;
+            }
+
+        public:
+            typedef decltype(std::declval<Adaptor&>().apply(
+                std::declval<typename cache_type::reference>())) reference;
+            typedef std::decay_t<reference> value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef void pointer;
+            typedef std::input_iterator_tag iterator_category;
+            typedef std::input_iterator_tag iterator_concept;
+
+            iterator() = default;
+
+            iterator(result_view* parent, base_iterator first, base_sentinel last)
+                : parent(parent), current(std::move(first)), last(std::move(last))
+            {
+                settle();
+            }
+
+            reference operator*() const
+            {
+                return parent->adaptor.apply(cache.get(current));
+            }
+
+            iterator& operator++()
+            {
+                cache.reset();
+                ++current;
+                settle();
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                auto previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            friend bool operator==(const iterator& x, const iterator& y)
+            {
+                return x.done == y.done && (x.done || x.current == y.current);
+            }
+
+            friend bool operator!=(const iterator& x, const iterator& y)
+            {
+                return !(x == y);
+            }
+        };
+
+        result_view(Range&& range, Adaptor adaptor)
+            : base(std::forward<Range>(range)), adaptor(std::move(adaptor))
+        {
+        }
+
+        iterator begin()
+        {
+            return iterator(this, std::begin(base.get()), std::end(base.get()));
+        }
+
+        iterator end()
+        {
+            return iterator();
+        }
+    };
+
+    /**
+     * Maps every ok value with F, leaving err values untouched, like `result::map` applied to
+     * each element.
+     *
+     * @param f F(T) -> U
+     * @return range of maybe::result<U, E>
+     */
+    template <typename F>
+    auto transform_ok(F f) -> internal::adaptor_closure<internal::transform_ok_adaptor<F>>
+    {
+        return {{internal::callable_box<F>(std::move(f))}};
+    }
+
+    template <typename Range, typename F>
+    auto transform_ok(Range&& range, F f)
+    {
+        return std::forward<Range>(range) | transform_ok(std::move(f));
+    }
+
+    /**
+     * Chains F on every ok value, leaving err values untouched, like `result::and_then` applied
+     * to each element.
+     *
+     * @param f F(T) -> maybe::result<U, E>
+     * @return range of maybe::result<U, E>
+     */
+    template <typename F>
+    auto and_then_each(F f) -> internal::adaptor_closure<internal::and_then_each_adaptor<F>>
+    {
+        return {{internal::callable_box<F>(std::move(f))}};
+    }
+
+    template <typename Range, typename F>
+    auto and_then_each(Range&& range, F f)
+    {
+        return std::forward<Range>(range) | and_then_each(std::move(f));
+    }
+
+    /**
+     * Skips err values and yields the contained ok values.
+     *
+     * @return range of T
+     */
+    inline auto filter_ok() noexcept -> internal::adaptor_closure<internal::filter_ok_adaptor>
+    {
+        return {};
+    }
+
+    template <typename Range>
+    auto filter_ok(Range&& range)
+    {
+        return std::forward<Range>(range) | filter_ok();
+    }
+
+    /**
+     * Yields the contained ok values up to, but not including, the first err value. The
+     * underlying range is not read past that err.
+     *
+     * @return range of T
+     */
+    inline auto take_while_ok() noexcept
+        -> internal::adaptor_closure<internal::take_while_ok_adaptor>
+    {
+        return {};
+    }
+
+    template <typename Range>
+    auto take_while_ok(Range&& range)
+    {
+        return std::forward<Range>(range) | take_while_ok();
+    }
+
+    /**
+     * Skips ok values and yields the contained err values.
+     *
+     * @return range of E
+     */
+    inline auto errors() noexcept -> internal::adaptor_closure<internal::errors_adaptor>
+    {
+        return {};
+    }
+
+    template <typename Range>
+    auto errors(Range&& range)
+    {
+        return std::forward<Range>(range) | errors();
+    }
+}
@@ -16,4 +16,6 @@ namespace maybe {
 
     template <typename E>
     class result<void, E>;
+
+    class cancel_token;
 }
\ No newline at end of file
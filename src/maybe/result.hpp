@@ -12,13 +12,214 @@
 
 #include "result.fwd.hpp"
 
+#include <cstdio>
+#include <cstdlib>
 #include <optional.hpp>
 #include <string>
+#include <type_traits>
+#include <utility>
+
+#if defined(__GNUC__)
+#define MAYBE_RESULT_NOINLINE_COLD __attribute__((noinline, cold))
+#elif defined(_MSC_VER)
+#define MAYBE_RESULT_NOINLINE_COLD __declspec(noinline)
+#else
+#define MAYBE_RESULT_NOINLINE_COLD
+#endif
+
+/*
+ * Combinators expect errors to be rare and mark the err branch unlikely, so that the ok path is
+ * laid out as straight-line code. Define MAYBE_RESULT_HOT_ERRORS for workloads where errors are
+ * common, to leave both branches unweighted.
+ *
+ * Define MAYBE_RESULT_COLD_ERRORS to also move err values that are not trivially copyable out
+ * of line, into cold functions. This shrinks the hot code of long combinator chains by about a
+ * third, at the cost of optimizations across the chain: tight loops run slower, so measure with
+ * the error_paths benchmark before enabling it.
+ */
+#if defined(MAYBE_RESULT_HOT_ERRORS) && defined(MAYBE_RESULT_COLD_ERRORS)
+#error "MAYBE_RESULT_HOT_ERRORS and MAYBE_RESULT_COLD_ERRORS are exclusive"
+#endif
+
+#if defined(__GNUC__) && !defined(MAYBE_RESULT_HOT_ERRORS)
+#define MAYBE_RESULT_UNLIKELY(condition) __builtin_expect(static_cast<bool>(condition), 0)
+#else
+#define MAYBE_RESULT_UNLIKELY(condition) static_cast<bool>(condition)
+#endif
+
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define MAYBE_RESULT_HAS_EXCEPTIONS 1
+#else
+#define MAYBE_RESULT_HAS_EXCEPTIONS 0
+#endif
+
+/*
+ * What accessing a value that a result does not hold does, e.g. `ok_value()` on an err:
+ *
+ * - MAYBE_RESULT_BAD_ACCESS_THROW throws `bad_optional_access`, the default with exceptions.
+ * - MAYBE_RESULT_BAD_ACCESS_ABORT prints a message and calls `std::abort`, the default without.
+ * - MAYBE_RESULT_BAD_ACCESS_HANDLER calls `maybe::bad_access_handler(message)`, which the
+ *   application defines and which must not return.
+ * - MAYBE_RESULT_BAD_ACCESS_ASSUME makes it undefined behaviour, so that checked accessors
+ *   compile to plain loads.
+ *
+ * Select one by defining MAYBE_RESULT_BAD_ACCESS before including the library, identically in
+ * every translation unit of a program.
+ */
+#define MAYBE_RESULT_BAD_ACCESS_THROW 1
+#define MAYBE_RESULT_BAD_ACCESS_ABORT 2
+#define MAYBE_RESULT_BAD_ACCESS_HANDLER 3
+#define MAYBE_RESULT_BAD_ACCESS_ASSUME 4
+
+#if !defined(MAYBE_RESULT_BAD_ACCESS)
+#if MAYBE_RESULT_HAS_EXCEPTIONS
+#define MAYBE_RESULT_BAD_ACCESS MAYBE_RESULT_BAD_ACCESS_THROW
+#else
+#define MAYBE_RESULT_BAD_ACCESS MAYBE_RESULT_BAD_ACCESS_ABORT
+#endif
+#endif
+
+#if MAYBE_RESULT_BAD_ACCESS == MAYBE_RESULT_BAD_ACCESS_THROW && !MAYBE_RESULT_HAS_EXCEPTIONS
+#error "MAYBE_RESULT_BAD_ACCESS_THROW requires exceptions"
+#endif
 
 namespace maybe {
+#if MAYBE_RESULT_BAD_ACCESS == MAYBE_RESULT_BAD_ACCESS_HANDLER
+    /**
+     * Called on bad access with MAYBE_RESULT_BAD_ACCESS_HANDLER. Defined by the application.
+     *
+     * @param message what was accessed
+     */
+    [[noreturn]] void bad_access_handler(const char* message);
+#endif
+
     namespace internal {
         struct placeholder {
         };
+
+        template <typename T>
+        struct is_result : std::false_type {
+        };
+
+        template <typename T, typename E>
+        struct is_result<result<T, E>> : std::true_type {
+        };
+
+        /**
+         * Ok result holding the value of `f(args...)`, or an empty ok result if `f` returns void.
+         */
+        template <typename Ret>
+        struct ok_of_call final {
+            template <typename F, typename... Args>
+            static Ret call(F& f, Args&&... args)
+            {
+                return Ret::ok(f(std::forward<Args>(args)...));
+            }
+        };
+
+        template <typename E>
+        struct ok_of_call<maybe::result<void, E>> final {
+            template <typename F, typename... Args>
+            static maybe::result<void, E> call(F& f, Args&&... args)
+            {
+                f(std::forward<Args>(args)...);
+                return maybe::result<void, E>::ok();
+            }
+        };
+
+#if MAYBE_RESULT_BAD_ACCESS == MAYBE_RESULT_BAD_ACCESS_ASSUME
+        [[noreturn]] inline void bad_access(const char*) noexcept
+        {
+#if defined(__GNUC__)
+            __builtin_unreachable();
+#elif defined(_MSC_VER)
+            __assume(0);
+#else
+            std::abort();
+#endif
+        }
+#else
+        /**
+         * Handle access to a value that a result does not hold, as selected by
+         * MAYBE_RESULT_BAD_ACCESS. Kept out of line and cold, so that a checked accessor inlines
+         * to a test and a rarely taken call.
+         *
+         * @param message what was accessed
+         */
+        [[noreturn]] MAYBE_RESULT_NOINLINE_COLD inline void bad_access(const char* message)
+        {
+#if MAYBE_RESULT_BAD_ACCESS == MAYBE_RESULT_BAD_ACCESS_THROW
+            (void)message;
+            throw std::experimental::bad_optional_access("bad optional access");
+#elif MAYBE_RESULT_BAD_ACCESS == MAYBE_RESULT_BAD_ACCESS_HANDLER
+            bad_access_handler(message);
+#else
+            std::fprintf(stderr, "maybe::result: %s\n", message);
+            std::abort();
+#endif
+        }
+#endif
+
+#if defined(MAYBE_RESULT_COLD_ERRORS)
+        inline namespace cold_errors {
+            template <typename R, typename E>
+            MAYBE_RESULT_NOINLINE_COLD R propagate_err_cold(E&& value) noexcept
+            {
+                return R(placeholder{}, std::move(value));
+            }
+
+            template <typename R, typename E>
+            inline R propagate_err(E&& value, std::true_type) noexcept
+            {
+                return R(placeholder{}, std::move(value));
+            }
+
+            template <typename R, typename E>
+            inline R propagate_err(E&& value, std::false_type) noexcept
+            {
+                return propagate_err_cold<R>(std::move(value));
+            }
+
+            /**
+             * Build the err result of a combinator from the err value it passes through. Err
+             * values that are not trivially copyable are moved in a cold function; trivially
+             * copyable ones stay inline, where they live in registers and cost less than a call.
+             * The inline namespace keeps this apart from the default definition.
+             *
+             * @param value err value to move
+             * @return R
+             */
+            template <typename R, typename E>
+            inline R propagate_err(E&& value) noexcept
+            {
+                return propagate_err<R>(
+                    std::move(value),
+                    std::is_trivially_copyable<typename std::decay<E>::type>{});
+            }
+        }
+#else
+        /**
+         * Build the err result of a combinator from the err value it passes through.
+         *
+         * @param value err value to move
+         * @return R
+         */
+        template <typename R, typename E>
+        inline R propagate_err(E&& value) noexcept
+        {
+            return R(placeholder{}, std::move(value));
+        }
+#endif
+
+        [[noreturn]] inline void bad_ok_access()
+        {
+            bad_access("ok_value() without ok value");
+        }
+
+        [[noreturn]] inline void bad_err_access()
+        {
+            bad_access("err_value() without err value");
+        }
     }
 
     template <typename T, typename E>
@@ -59,13 +260,12 @@ namespace maybe {
          */
         constexpr static result<T, E> ok(T&& value) noexcept
         {
-            return std::forward<result<T, E>>(
-                result<T, E>(std::forward<T>(value), internal::placeholder{}));
+            return result<T, E>(std::move(value), internal::placeholder{});
         }
 
         constexpr static result<T, E> ok(const T& value) noexcept
         {
-            return std::forward<result<T, E>>(result<T, E>(value, internal::placeholder{}));
+            return result<T, E>(value, internal::placeholder{});
         }
 
         /**
@@ -76,13 +276,12 @@ namespace maybe {
          */
         constexpr static result<T, E> err(E&& value) noexcept
         {
-            return std::forward<result<T, E>>(
-                result<T, E>(internal::placeholder{}, std::forward<E>(value)));
+            return result<T, E>(internal::placeholder{}, std::move(value));
         }
 
         constexpr static result<T, E> err(const E& value) noexcept
         {
-            return std::forward<result<T, E>>(result<T, E>(internal::placeholder{}, value));
+            return result<T, E>(internal::placeholder{}, value);
         }
 
         /**
@@ -92,7 +291,7 @@ namespace maybe {
          */
         constexpr static result<T, E> default_ok() noexcept
         {
-            return std::experimental::constexpr_move(result<T, E>(T(), internal::placeholder{}));
+            return result<T, E>(T(), internal::placeholder{});
         }
 
         /**
@@ -102,7 +301,7 @@ namespace maybe {
          */
         constexpr static result<T, E> default_err() noexcept
         {
-            return std::experimental::constexpr_move(result<T, E>(internal::placeholder{}, E()));
+            return result<T, E>(internal::placeholder{}, E());
         }
 
         // Inspection.
@@ -136,34 +335,35 @@ namespace maybe {
 
         constexpr T const& ok_value() const&
         {
-            return var_ok.value();
+            return var_ok ? *var_ok : (internal::bad_ok_access(), *var_ok);
         }
 
         OPTIONAL_MUTABLE_CONSTEXPR T& ok_value() &
         {
-            return var_ok.value();
+            return var_ok ? *var_ok : (internal::bad_ok_access(), *var_ok);
         }
 
         OPTIONAL_MUTABLE_CONSTEXPR T&& ok_value() &&
         {
-            return std::move(var_ok.value());
+            return std::move(var_ok ? *var_ok : (internal::bad_ok_access(), *var_ok));
         }
 
 #else
 
         /**
-         * Retrieve ok value or throw `bad_optional_access` exception.
+         * Retrieve ok value. Accessing an err result is handled by MAYBE_RESULT_BAD_ACCESS, which
+         * throws `bad_optional_access` by default.
          *
          * @return T
          */
         constexpr T const& ok_value() const
         {
-            return var_ok.value();
+            return var_ok ? *var_ok : (internal::bad_ok_access(), *var_ok);
         }
 
         T& ok_value()
         {
-            return var_ok.value();
+            return var_ok ? *var_ok : (internal::bad_ok_access(), *var_ok);
         }
 
 #endif
@@ -213,34 +413,35 @@ namespace maybe {
 
         constexpr E const& err_value() const&
         {
-            return var_err.value();
+            return var_err ? *var_err : (internal::bad_err_access(), *var_err);
         }
 
         OPTIONAL_MUTABLE_CONSTEXPR E& err_value() &
         {
-            return var_err.value();
+            return var_err ? *var_err : (internal::bad_err_access(), *var_err);
         }
 
         OPTIONAL_MUTABLE_CONSTEXPR E&& err_value() &&
         {
-            return std::move(var_err.value());
+            return std::move(var_err ? *var_err : (internal::bad_err_access(), *var_err));
         }
 
 #else
 
         /**
-         * Retrieve err value or throw `bad_optional_access` exception.
+         * Retrieve err value. Accessing an ok result is handled by MAYBE_RESULT_BAD_ACCESS, which
+         * throws `bad_optional_access` by default.
          *
          * @return E
          */
         constexpr E const& err_value() const
         {
-            return var_err.value();
+            return var_err ? *var_err : (internal::bad_err_access(), *var_err);
         }
 
         E& err_value()
         {
-            return var_err.value();
+            return var_err ? *var_err : (internal::bad_err_access(), *var_err);
         }
 
 #endif
@@ -293,13 +494,23 @@ namespace maybe {
          * function F to a
          * contained ok value, leaving an err value untouched.
          *
-         * This function can be used to compose the results of two functions.
+         * This function can be used to compose the results of two functions. `f` receives the ok
+         * value as an lvalue and an err value is copied, so that the result keeps both.
          *
          * @param f F(T) -> U
          * @return maybe::result<U, E>
          */
         template <typename F, typename R = typename std::result_of<F(T)>::type>
-        inline auto map(F f) noexcept -> maybe::result<R, E>;
+        inline auto map(F f) & noexcept -> maybe::result<R, E>;
+
+        /**
+         * Same as `map`, but moves the ok value into `f` or the err value into the returned result.
+         *
+         * @param f F(T) -> U
+         * @return maybe::result<U, E>
+         */
+        template <typename F, typename R = typename std::result_of<F(T)>::type>
+        inline auto map(F f) && noexcept -> maybe::result<R, E>;
 
         /**
          * Maps a result<T, E> to result<void, E>, leaving an err value untouched.
@@ -327,12 +538,26 @@ namespace maybe {
          * contained err value, leaving an ok value untouched.
          *
          * This function can be used to pass through a successful result while changing an error.
+         * `f` receives the err value as an lvalue and an ok value is copied, so that the result
+         * keeps both.
          *
          * @param f F(E) -> U
          * @return maybe::result<T, U>
          */
         template <typename F>
-        inline auto map_err(F f) noexcept -> maybe::result<T, typename std::result_of<F(E)>::type>;
+        inline auto map_err(F f) & noexcept
+            -> maybe::result<T, typename std::result_of<F(E)>::type>;
+
+        /**
+         * Same as `map_err`, but moves the err value into `f` or the ok value into the returned
+         * result.
+         *
+         * @param f F(E) -> U
+         * @return maybe::result<T, U>
+         */
+        template <typename F>
+        inline auto map_err(F f) && noexcept
+            -> maybe::result<T, typename std::result_of<F(E)>::type>;
 
         /**
          * Maps a result<T, E> to result<T, U> by always returning provided U value on error,
@@ -349,13 +574,51 @@ namespace maybe {
         /**
          * Calls op if the result is ok, otherwise returns the err value of self.
          *
-         * This function can be used for control flow based on result values.
+         * This function can be used for control flow based on result values. `f` receives the ok
+         * value as an lvalue and an err value is copied, so that the result keeps both.
+         *
+         * @param f F(T) -> maybe::result<U, E>
+         * @return maybe::result<U, E>
+         */
+        template <typename F>
+        inline auto and_then(F op) & noexcept -> typename std::result_of<F(T)>::type;
+
+        /**
+         * Same as `and_then`, but moves the ok value into `f` or the err value into the returned
+         * result.
+         *
+         * @param f F(T) -> maybe::result<U, E>
+         * @return maybe::result<U, E>
+         */
+        template <typename F>
+        inline auto and_then(F op) && noexcept -> typename std::result_of<F(T)>::type;
+
+        /**
+         * Calls op if the result is ok and the token is not cancelled, otherwise returns the err
+         * value of self, or an err value converted from the cancel reason with
+         * `maybe::cancel_error<E>`.
+         *
+         * Defined in `maybe/cancel_token.hpp`.
          *
+         * @param token maybe::cancel_token
          * @param f F(T) -> maybe::result<U, E>
          * @return maybe::result<U, E>
          */
         template <typename F>
-        inline auto and_then(F op) noexcept -> typename std::result_of<F(T)>::type;
+        inline auto and_then(const cancel_token& token, F op) & noexcept ->
+            typename std::result_of<F(T)>::type;
+
+        /**
+         * Same as `and_then` with a token, but moves the ok value into `f` or the err value into
+         * the returned result.
+         *
+         * @param token maybe::cancel_token
+         * @param f F(T) -> maybe::result<U, E>
+         * @return maybe::result<U, E>
+         */
+        template <typename F>
+        inline auto and_then(const cancel_token& token, F op) && noexcept ->
+            typename std::result_of<F(T)>::type;
 
         /**
          * Converts into another result with different ok type `U` and forwards the same error.
@@ -366,6 +629,16 @@ namespace maybe {
          */
         template <typename U>
         inline auto into_err() noexcept -> maybe::result<U, E> const;
+
+        /**
+         * Converts a result<result<U, E>, E> into result<U, E> by moving the inner result out,
+         * or forwarding the outer err value.
+         *
+         * @return maybe::result<U, E>
+         */
+        template <typename R = T>
+        inline auto flatten() && noexcept ->
+            typename std::enable_if<internal::is_result<R>::value, R>::type;
     };
 
     template <typename T, typename E>
@@ -419,7 +692,7 @@ namespace maybe {
          */
         constexpr static result<void, E> ok() noexcept
         {
-            return std::forward<result<void, E>>(result<void, E>());
+            return result<void, E>();
         }
 
         /**
@@ -430,12 +703,12 @@ namespace maybe {
          */
         constexpr static result<void, E> err(E&& value) noexcept
         {
-            return std::forward<result<void, E>>(result<void, E>(std::forward<E>(value)));
+            return result<void, E>(internal::placeholder{}, std::move(value));
         }
 
         constexpr static result<void, E> err(const E& value) noexcept
         {
-            return std::forward<result<void, E>>(result<void, E>(value));
+            return result<void, E>(internal::placeholder{}, value);
         }
 
         /**
@@ -445,7 +718,7 @@ namespace maybe {
          */
         constexpr static result<void, E> default_ok() noexcept
         {
-            return std::experimental::constexpr_move(result<void, E>());
+            return result<void, E>();
         }
 
         /**
@@ -455,7 +728,7 @@ namespace maybe {
          */
         constexpr static result<void, E> default_err() noexcept
         {
-            return std::experimental::constexpr_move(result<void, E>(E()));
+            return result<void, E>(internal::placeholder{}, E());
         }
 
         // Inspection.
@@ -488,7 +761,7 @@ namespace maybe {
         void ok_value()
         {
             if (is_err()) {
-                throw std::experimental::bad_optional_access("bad optional access");
+                internal::bad_ok_access();
             }
         }
 
@@ -496,34 +769,35 @@ namespace maybe {
 
         constexpr E const& err_value() const&
         {
-            return var_err.value();
+            return var_err ? *var_err : (internal::bad_err_access(), *var_err);
         }
 
         OPTIONAL_MUTABLE_CONSTEXPR E& err_value() &
         {
-            return var_err.value();
+            return var_err ? *var_err : (internal::bad_err_access(), *var_err);
         }
 
         OPTIONAL_MUTABLE_CONSTEXPR E&& err_value() &&
         {
-            return std::move(var_err.value());
+            return std::move(var_err ? *var_err : (internal::bad_err_access(), *var_err));
         }
 
 #else
 
         /**
-         * Retrieve err value or throw `bad_optional_access` exception.
+         * Retrieve err value. Accessing an ok result is handled by MAYBE_RESULT_BAD_ACCESS, which
+         * throws `bad_optional_access` by default.
          *
          * @return E
          */
         E const& err_value() const
         {
-            return var_err.value();
+            return var_err ? *var_err : (internal::bad_err_access(), *var_err);
         }
 
         E& err_value()
         {
-            return var_err.value();
+            return var_err ? *var_err : (internal::bad_err_access(), *var_err);
         }
 
 #endif
@@ -591,12 +865,23 @@ namespace maybe {
          * contained err value, leaving an ok value untouched.
          *
          * This function can be used to pass through a successful result while changing an error.
+         * `f` receives the err value as an lvalue, so that the result keeps it.
          *
          * @param f F(E) -> U
          * @return maybe::result<void, U>
          */
         template <typename F>
-        inline auto map_err(F f) noexcept
+        inline auto map_err(F f) & noexcept
+            -> maybe::result<void, typename std::result_of<F(E)>::type>;
+
+        /**
+         * Same as `map_err`, but moves the err value into `f`.
+         *
+         * @param f F(E) -> U
+         * @return maybe::result<void, U>
+         */
+        template <typename F>
+        inline auto map_err(F f) && noexcept
             -> maybe::result<void, typename std::result_of<F(E)>::type>;
 
         /**
@@ -622,6 +907,21 @@ namespace maybe {
         template <typename F>
         inline auto and_then(F op) noexcept -> typename std::result_of<F()>::type;
 
+        /**
+         * Calls op if the result is ok and the token is not cancelled, otherwise returns the err
+         * value of self, or an err value converted from the cancel reason with
+         * `maybe::cancel_error<E>`.
+         *
+         * Defined in `maybe/cancel_token.hpp`.
+         *
+         * @param token maybe::cancel_token
+         * @param f F() -> maybe::result<U, E>
+         * @return maybe::result<U, E>
+         */
+        template <typename F>
+        inline auto and_then(const cancel_token& token, F op) noexcept ->
+            typename std::result_of<F()>::type;
+
         /**
          * Converts into another result with ok type void and forwards the same error.
          *
@@ -14,20 +14,31 @@
 
 template <typename T, typename E>
 template <typename F, typename R>
-inline auto maybe::result<T, E>::map(F f) noexcept -> maybe::result<R, E>
+inline auto maybe::result<T, E>::map(F f) & noexcept -> maybe::result<R, E>
 {
-    if (is_err()) {
-        return maybe::result<R, E>::err(std::forward<E>(err_value()));
+    if (MAYBE_RESULT_UNLIKELY(var_err)) {
+        return internal::propagate_err<maybe::result<R, E>>(E(*var_err));
     }
 
     return maybe::result<R, E>(f(ok_value()), internal::placeholder{});
 };
 
+template <typename T, typename E>
+template <typename F, typename R>
+inline auto maybe::result<T, E>::map(F f) && noexcept -> maybe::result<R, E>
+{
+    if (MAYBE_RESULT_UNLIKELY(var_err)) {
+        return internal::propagate_err<maybe::result<R, E>>(std::move(*var_err));
+    }
+
+    return maybe::result<R, E>(f(std::move(ok_value())), internal::placeholder{});
+};
+
 template <typename T, typename E>
 inline auto maybe::result<T, E>::map_void() noexcept -> maybe::result<void, E>
 {
-    if (is_err()) {
-        return maybe::result<void, E>::err(std::forward<E>(err_value()));
+    if (MAYBE_RESULT_UNLIKELY(var_err)) {
+        return internal::propagate_err<maybe::result<void, E>>(std::move(*var_err));
     }
 
     return maybe::result<void, E>();
@@ -37,59 +48,98 @@ template <typename T, typename E>
 template <typename U>
 inline auto maybe::result<T, E>::map_value(U value) noexcept -> maybe::result<U, E>
 {
-    if (is_err()) {
-        return maybe::result<U, E>::err(std::forward<E>(err_value()));
+    if (MAYBE_RESULT_UNLIKELY(var_err)) {
+        return internal::propagate_err<maybe::result<U, E>>(std::move(*var_err));
     }
 
-    return maybe::result<U, E>(std::forward<U>(value), internal::placeholder{});
+    return maybe::result<U, E>(std::move(value), internal::placeholder{});
 };
 
 template <typename T, typename E>
 template <typename F>
-inline auto maybe::result<T, E>::map_err(F f) noexcept
+inline auto maybe::result<T, E>::map_err(F f) & noexcept
     -> maybe::result<T, typename std::result_of<F(E)>::type>
 {
     typedef maybe::result<T, typename std::result_of<F(E)>::type> return_result_t;
 
-    if (is_ok()) {
-        return return_result_t(std::forward<T>(ok_value()), internal::placeholder{});
+    if (var_ok) {
+        return return_result_t(*var_ok, internal::placeholder{});
     }
     return return_result_t(internal::placeholder{}, f(err_value()));
 };
 
+template <typename T, typename E>
+template <typename F>
+inline auto maybe::result<T, E>::map_err(F f) && noexcept
+    -> maybe::result<T, typename std::result_of<F(E)>::type>
+{
+    typedef maybe::result<T, typename std::result_of<F(E)>::type> return_result_t;
+
+    if (var_ok) {
+        return return_result_t(std::move(*var_ok), internal::placeholder{});
+    }
+    return return_result_t(internal::placeholder{}, f(std::move(err_value())));
+};
+
 template <typename T, typename E>
 template <typename U>
 inline auto maybe::result<T, E>::map_err_value(U value) noexcept -> maybe::result<T, U>
 {
-    if (is_ok()) {
-        return maybe::result<T, U>(std::forward<T>(ok_value()), internal::placeholder{});
+    if (var_ok) {
+        return maybe::result<T, U>(std::move(*var_ok), internal::placeholder{});
     }
 
-    return maybe::result<T, U>::err(std::forward<U>(value));
+    return maybe::result<T, U>(internal::placeholder{}, std::move(value));
 };
 
 template <typename T, typename E>
 template <typename F>
-inline auto maybe::result<T, E>::and_then(F f) noexcept -> typename std::result_of<F(T)>::type
+inline auto maybe::result<T, E>::and_then(F f) & noexcept -> typename std::result_of<F(T)>::type
 {
     typedef typename std::result_of<F(T)>::type result_t;
 
-    if (is_err()) {
-        return maybe::result<typename result_t::ok_type, E>::err(std::forward<E>(err_value()));
+    if (MAYBE_RESULT_UNLIKELY(var_err)) {
+        return internal::propagate_err<result_t>(E(*var_err));
     }
     return f(ok_value());
 };
 
+template <typename T, typename E>
+template <typename F>
+inline auto maybe::result<T, E>::and_then(F f) && noexcept -> typename std::result_of<F(T)>::type
+{
+    typedef typename std::result_of<F(T)>::type result_t;
+
+    if (MAYBE_RESULT_UNLIKELY(var_err)) {
+        return internal::propagate_err<result_t>(std::move(*var_err));
+    }
+    return f(std::move(ok_value()));
+};
+
 template <typename T, typename E>
 template <typename U>
 inline auto maybe::result<T, E>::into_err() noexcept -> maybe::result<U, E> const
 {
-    if (is_err()) {
-        return maybe::result<U, E>(internal::placeholder{}, std::forward<E>(err_value()));
+    if (MAYBE_RESULT_UNLIKELY(var_err)) {
+        return internal::propagate_err<maybe::result<U, E>>(std::move(*var_err));
     }
     return maybe::result<U, E>::default_ok();
 };
 
+template <typename T, typename E>
+template <typename R>
+inline auto maybe::result<T, E>::flatten() && noexcept ->
+    typename std::enable_if<internal::is_result<R>::value, R>::type
+{
+    static_assert(std::is_same<typename R::err_type, E>::value,
+                  "flatten requires the inner result to have the same err type");
+
+    if (MAYBE_RESULT_UNLIKELY(var_err)) {
+        return internal::propagate_err<R>(std::move(*var_err));
+    }
+    return std::move(ok_value());
+};
+
 template <typename E>
 template <typename F>
 inline auto maybe::result<void, E>::map(F f) noexcept
@@ -97,8 +147,8 @@ inline auto maybe::result<void, E>::map(F f) noexcept
 {
     typedef maybe::result<typename std::result_of<F()>::type, E> return_result_t;
 
-    if (is_err()) {
-        return return_result_t::err(std::forward<E>(err_value()));
+    if (MAYBE_RESULT_UNLIKELY(var_err)) {
+        return internal::propagate_err<return_result_t>(std::move(*var_err));
     }
     return return_result_t(f(), internal::placeholder{});
 };
@@ -107,35 +157,48 @@ template <typename E>
 template <typename U>
 inline auto maybe::result<void, E>::map_value(U value) noexcept -> maybe::result<U, E>
 {
-    if (is_err()) {
-        return maybe::result<U, E>::err(std::forward<E>(err_value()));
+    if (MAYBE_RESULT_UNLIKELY(var_err)) {
+        return internal::propagate_err<maybe::result<U, E>>(std::move(*var_err));
     }
 
-    return maybe::result<U, E>(std::forward<U>(value), internal::placeholder{});
+    return maybe::result<U, E>(std::move(value), internal::placeholder{});
 };
 
 template <typename E>
 template <typename F>
-inline auto maybe::result<void, E>::map_err(F f) noexcept
+inline auto maybe::result<void, E>::map_err(F f) & noexcept
     -> maybe::result<void, typename std::result_of<F(E)>::type>
 {
     typedef maybe::result<void, typename std::result_of<F(E)>::type> return_result_t;
 
-    if (is_ok()) {
-        return return_result_t::ok();
+    if (!var_err) {
+        return return_result_t();
     }
-    return return_result_t(internal::placeholder{}, f(err_value()));
+    return return_result_t(internal::placeholder{}, f(*var_err));
+};
+
+template <typename E>
+template <typename F>
+inline auto maybe::result<void, E>::map_err(F f) && noexcept
+    -> maybe::result<void, typename std::result_of<F(E)>::type>
+{
+    typedef maybe::result<void, typename std::result_of<F(E)>::type> return_result_t;
+
+    if (!var_err) {
+        return return_result_t();
+    }
+    return return_result_t(internal::placeholder{}, f(std::move(*var_err)));
 };
 
 template <typename E>
 template <typename U>
 inline auto maybe::result<void, E>::map_err_value(U value) noexcept -> maybe::result<void, U>
 {
-    if (is_ok()) {
-        return maybe::result<void, U>::ok();
+    if (!var_err) {
+        return maybe::result<void, U>();
     }
 
-    return maybe::result<void, U>(std::forward<U>(value));
+    return maybe::result<void, U>(internal::placeholder{}, std::move(value));
 };
 
 template <typename E>
@@ -144,8 +207,8 @@ inline auto maybe::result<void, E>::and_then(F f) noexcept -> typename std::resu
 {
     typedef typename std::result_of<F()>::type result_t;
 
-    if (is_err()) {
-        return maybe::result<typename result_t::ok_type, E>::err(std::forward<E>(err_value()));
+    if (MAYBE_RESULT_UNLIKELY(var_err)) {
+        return internal::propagate_err<result_t>(std::move(*var_err));
     }
     return f();
 };
@@ -153,8 +216,8 @@ inline auto maybe::result<void, E>::and_then(F f) noexcept -> typename std::resu
 template <typename E>
 inline auto maybe::result<void, E>::into_err() noexcept -> maybe::result<void, E>
 {
-    if (is_err()) {
-        return maybe::result<void, E>(std::forward<E>(err_value()));
+    if (MAYBE_RESULT_UNLIKELY(var_err)) {
+        return internal::propagate_err<maybe::result<void, E>>(std::move(*var_err));
     }
-    return maybe::result<void, E>::default_ok();
+    return maybe::result<void, E>();
 };
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include "async_result.hpp"
+#include "result.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace maybe {
+    /**
+     * When and how often `maybe::retry` calls a function again after an err result.
+     *
+     * The delay before retry `n` (counting from zero) is `initial_delay * multiplier^n`, capped
+     * at `max_delay`, of which a random fraction of up to `jitter` is subtracted so that clients
+     * failing together do not retry together.
+     */
+    template <typename E>
+    struct retry_policy final {
+        std::size_t max_attempts = 3;
+        std::chrono::steady_clock::duration initial_delay = std::chrono::milliseconds(10);
+        std::chrono::steady_clock::duration max_delay = std::chrono::seconds(1);
+        double multiplier = 2.0;
+        double jitter = 0.5;
+        std::function<bool(const E&)> should_retry = [](const E&) { return true; };
+
+        /**
+         * Delay before the retry following `attempt` failed attempts, including jitter.
+         *
+         * @param attempt number of attempts made so far, starting at 1
+         * @return std::chrono::steady_clock::duration
+         */
+        std::chrono::steady_clock::duration delay(std::size_t attempt) const
+        {
+            static thread_local std::minstd_rand random(std::random_device{}());
+
+            auto base = static_cast<double>(initial_delay.count());
+            auto cap = static_cast<double>(max_delay.count());
+            for (std::size_t i = 1; i < attempt && base < cap; ++i) {
+                base *= multiplier;
+            }
+            base = std::min(base, cap);
+
+            std::uniform_real_distribution<double> fraction(0.0,
+                                                            std::max(0.0, std::min(jitter, 1.0)));
+            return std::chrono::steady_clock::duration(
+                static_cast<std::chrono::steady_clock::rep>(base * (1.0 - fraction(random))));
+        }
+
+        /**
+         * Check if another attempt should follow an err result.
+         *
+         * @param attempt number of attempts made so far, starting at 1
+         * @param error err value of the last attempt
+         * @return bool
+         */
+        bool retries(std::size_t attempt, const E& error) const
+        {
+            return attempt < max_attempts && (!should_retry || should_retry(error));
+        }
+    };
+
+    /**
+     * Call `f` until it returns an ok result, the policy rejects the error, or the attempts run
+     * out. Sleeps the calling thread between attempts.
+     *
+     * @param policy maybe::retry_policy<E>
+     * @param f F() -> maybe::result<T, E>
+     * @return result of the last attempt
+     */
+    template <typename E, typename F, typename R = typename std::result_of<F()>::type>
+    auto retry(const retry_policy<E>& policy, F f) -> R
+    {
+        static_assert(std::is_same<typename R::err_type, E>::value,
+                      "retry requires a function returning the policy's err type");
+
+        for (std::size_t attempt = 1;; ++attempt) {
+            auto r = f();
+            if (r.is_ok() || !policy.retries(attempt, r.err_value())) {
+                return r;
+            }
+            std::this_thread::sleep_for(policy.delay(attempt));
+        }
+    }
+
+    namespace internal {
+        template <typename Executor, typename F, typename T, typename E>
+        struct retry_state final : std::enable_shared_from_this<retry_state<Executor, F, T, E>> {
+            Executor& executor;
+            retry_policy<E> policy;
+            F f;
+            async_promise<T, E> promise;
+            std::size_t attempt = 0;
+
+            retry_state(Executor& executor, retry_policy<E> policy, F f)
+                : executor(executor), policy(std::move(policy)), f(std::move(f))
+            {
+            }
+
+            void run()
+            {
+                ++attempt;
+                on_settled(f());
+            }
+
+            void on_settled(maybe::result<T, E>&& r)
+            {
+                if (r.is_ok() || !policy.retries(attempt, r.err_value())) {
+                    promise.set(std::move(r));
+                    return;
+                }
+                auto self = this->shared_from_this();
+                executor.execute_after(policy.delay(attempt), [self]() { self->run(); });
+            }
+
+            void on_settled(async_result<T, E>&& r)
+            {
+                auto self = this->shared_from_this();
+                std::move(r).on_ready(
+                    [self](maybe::result<T, E>&& r) { self->on_settled(std::move(r)); });
+            }
+        };
+    }
+
+    /**
+     * Asynchronous `retry`. Attempts run on `executor`, and the wait between attempts is a timer
+     * on the executor rather than a sleeping thread.
+     *
+     * @param executor executor with `execute(f)` and `execute_after(delay, f)`, such as
+     *        maybe::executor
+     * @param policy maybe::retry_policy<E>
+     * @param f F() -> maybe::result<T, E> or maybe::async_result<T, E>
+     * @return maybe::async_result<T, E>
+     */
+    template <typename Executor,
+              typename E,
+              typename F,
+              typename R = typename internal::async_traits<typename std::result_of<F()>::type>::result_type>
+    auto retry_async(Executor& executor, retry_policy<E> policy, F f)
+        -> async_result<typename R::ok_type, E>
+    {
+        static_assert(std::is_same<typename R::err_type, E>::value,
+                      "retry_async requires a function returning the policy's err type");
+        typedef internal::retry_state<Executor, F, typename R::ok_type, E> state_t;
+
+        auto state = std::make_shared<state_t>(executor, std::move(policy), std::move(f));
+        auto out = state->promise.get_async_result();
+        executor.execute([state]() { state->run(); });
+        return out;
+    }
+}
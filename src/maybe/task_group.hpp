@@ -0,0 +1,346 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include "atomic_wait.hpp"
+#include "cancel_token.hpp"
+#include "executor.hpp"
+#include "result.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace maybe {
+    namespace internal {
+        /**
+         * Bump allocator that releases all of its memory at once on destruction. Allocation from
+         * the current block is a single atomic add, a new block is only allocated under a lock
+         * once the current one is exhausted.
+         */
+        class arena final {
+        private:
+            struct alignas(std::max_align_t) block final {
+                block* previous;
+                std::size_t size;
+                std::atomic<std::size_t> used{0};
+
+                block(block* previous, std::size_t size) : previous(previous), size(size)
+                {
+                }
+
+                unsigned char* data() noexcept
+                {
+                    return reinterpret_cast<unsigned char*>(this + 1);
+                }
+            };
+
+            const std::size_t block_size;
+            std::atomic<block*> current{nullptr};
+            std::mutex grow_mutex;
+
+            static std::size_t align_up(std::size_t n, std::size_t alignment) noexcept
+            {
+                return (n + alignment - 1) & ~(alignment - 1);
+            }
+
+            void grow(block* seen, std::size_t min_size)
+            {
+                std::lock_guard<std::mutex> lock(grow_mutex);
+                if (current.load(std::memory_order_acquire) != seen) {
+                    return;
+                }
+                auto size = std::max(block_size, min_size);
+                auto memory = ::operator new(sizeof(block) + size);
+                current.store(::new (memory) block(seen, size), std::memory_order_release);
+            }
+
+        public:
+            explicit arena(std::size_t block_size) : block_size(block_size)
+            {
+            }
+
+            arena(const arena&) = delete;
+            arena& operator=(const arena&) = delete;
+
+            ~arena()
+            {
+                auto b = current.load(std::memory_order_relaxed);
+                while (b != nullptr) {
+                    auto previous = b->previous;
+                    b->~block();
+                    ::operator delete(b);
+                    b = previous;
+                }
+            }
+
+            /**
+             * Allocate `size` bytes aligned to `alignof(std::max_align_t)`.
+             */
+            void* allocate(std::size_t size)
+            {
+                size = align_up(size, alignof(std::max_align_t));
+                for (;;) {
+                    auto b = current.load(std::memory_order_acquire);
+                    if (b != nullptr) {
+                        auto offset = b->used.fetch_add(size, std::memory_order_relaxed);
+                        if (offset + size <= b->size) {
+                            return b->data() + offset;
+                        }
+                    }
+                    grow(b, size);
+                }
+            }
+        };
+
+        /**
+         * Moves the ok value of a task's result to its destination, if it has one.
+         */
+        template <typename T>
+        struct group_store final {
+            template <typename R>
+            static void store(R& r, T* out)
+            {
+                if (out != nullptr) {
+                    *out = std::move(r.ok_value());
+                }
+            }
+        };
+
+        template <>
+        struct group_store<void> final {
+            template <typename R>
+            static void store(R&, void*) noexcept
+            {
+            }
+        };
+    }
+
+    /**
+     * Scope for tasks that fail together.
+     *
+     * Tasks spawned into the group run on an executor and return `maybe::result<T, E>`. The
+     * first err value cancels the group's token, so that queued tasks are skipped and running
+     * tasks can stop early, and is returned by `wait`. A task that throws fails the group the same
+     * way, and `wait` rethrows its exception. The destructor waits for all tasks, so no task
+     * outlives the scope that spawned it, but does not rethrow.
+     *
+     * Task nodes are allocated from an arena owned by the group and released together with it.
+     */
+    template <typename E>
+    class task_group final {
+    private:
+        template <typename F, typename T>
+        class group_task final : public internal::task {
+        private:
+            task_group& group;
+            F f;
+            T* out;
+
+        public:
+            template <typename G>
+            group_task(task_group& group, G&& f, T* out)
+                : group(group), f(std::forward<G>(f)), out(out)
+            {
+            }
+
+            void complete()
+            {
+                auto r = f();
+                if (r.is_err()) {
+                    group.fail(std::move(r.err_value()));
+                } else {
+                    internal::group_store<T>::store(r, out);
+                }
+            }
+
+            void run() override
+            {
+                auto& g = group;
+                if (!g.token().is_cancelled()) {
+#if MAYBE_RESULT_HAS_EXCEPTIONS
+                    try {
+                        complete();
+                    } catch (...) {
+                        g.fail(std::current_exception());
+                    }
+#else
+                    complete();
+#endif
+                }
+                this->~group_task();
+                g.finish();
+            }
+        };
+
+        maybe::executor& executor;
+        internal::arena arena;
+        cancel_token cancel;
+        std::atomic<std::size_t> pending{0};
+        // Tasks between their decrement of `pending` and their last access to the group.
+        std::atomic<std::size_t> finishing{0};
+        std::atomic<bool> failed{false};
+        std::experimental::optional<E> first_error;
+#if MAYBE_RESULT_HAS_EXCEPTIONS
+        std::exception_ptr first_exception;
+#endif
+
+        void fail(E&& error)
+        {
+            if (!failed.exchange(true, std::memory_order_acq_rel)) {
+                first_error.emplace(std::move(error));
+                cancel.cancel();
+            }
+        }
+
+#if MAYBE_RESULT_HAS_EXCEPTIONS
+        void fail(std::exception_ptr exception) noexcept
+        {
+            if (!failed.exchange(true, std::memory_order_acq_rel)) {
+                first_exception = std::move(exception);
+                cancel.cancel();
+            }
+        }
+#endif
+
+        void finish() noexcept
+        {
+            finishing.fetch_add(1, std::memory_order_relaxed);
+            if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                internal::atomic_notify_all(pending);
+            }
+            finishing.fetch_sub(1, std::memory_order_release);
+        }
+
+        template <typename T, typename F>
+        void post(F&& f, T* out)
+        {
+            typedef group_task<typename std::decay<F>::type, T> task_t;
+
+            static_assert(alignof(task_t) <= alignof(std::max_align_t),
+                          "task_group does not support over-aligned tasks");
+            auto memory = arena.allocate(sizeof(task_t));
+            auto t = ::new (memory) task_t(*this, std::forward<F>(f), out);
+            pending.fetch_add(1, std::memory_order_relaxed);
+            executor.post(t);
+        }
+
+        void wait_all()
+        {
+            if (executor.in_worker()) {
+                while (pending.load(std::memory_order_acquire) != 0) {
+                    if (!executor.try_run_one()) {
+                        std::this_thread::yield();
+                    }
+                }
+            } else {
+                for (auto n = pending.load(std::memory_order_acquire); n != 0;
+                     n = pending.load(std::memory_order_acquire)) {
+                    internal::atomic_wait(pending, n);
+                }
+            }
+            // The group may be destroyed once this returns, so wait for the last task to be
+            // done notifying `pending`. This spans a single notify call, so spinning is fine.
+            while (finishing.load(std::memory_order_acquire) != 0) {
+                std::this_thread::yield();
+            }
+        }
+
+    public:
+        /**
+         * @param executor runs the tasks
+         * @param arena_block_size bytes allocated at once for task nodes
+         */
+        explicit task_group(maybe::executor& executor, std::size_t arena_block_size = 16 * 1024)
+            : executor(executor), arena(arena_block_size)
+        {
+        }
+
+        task_group(const task_group&) = delete;
+        task_group& operator=(const task_group&) = delete;
+
+        ~task_group()
+        {
+            wait_all();
+        }
+
+        /**
+         * Token cancelled by the first error. Long running tasks can poll it to stop early.
+         *
+         * @return const maybe::cancel_token&
+         */
+        const cancel_token& token() const noexcept
+        {
+            return cancel;
+        }
+
+        /**
+         * Run `f` on the executor. The ok value, if any, is discarded.
+         *
+         * @param f F() -> maybe::result<T, E>
+         */
+        template <typename F,
+                  typename R = typename std::result_of<typename std::decay<F>::type&()>::type>
+        void spawn(F&& f)
+        {
+            static_assert(std::is_same<typename R::err_type, E>::value,
+                          "task_group requires tasks returning its err type");
+            post<void>(std::forward<F>(f), nullptr);
+        }
+
+        /**
+         * Run `f` on the executor and move its ok value to `out`. `out` must stay valid until
+         * `wait` returns, and is only written if `f` returns ok.
+         *
+         * @param out destination of the ok value
+         * @param f F() -> maybe::result<T, E>
+         */
+        template <typename T,
+                  typename F,
+                  typename R = typename std::result_of<typename std::decay<F>::type&()>::type>
+        void spawn(T& out, F&& f)
+        {
+            static_assert(std::is_same<typename R::err_type, E>::value,
+                          "task_group requires tasks returning its err type");
+            post<T>(std::forward<F>(f), &out);
+        }
+
+        /**
+         * Wait for all spawned tasks, including tasks spawned by other tasks. A worker thread of
+         * the group's executor runs queued tasks while it waits.
+         *
+         * Rethrows the exception of the first task that threw, if that failed the group.
+         *
+         * @return ok, or the first err value returned by a task
+         */
+        result<void, E> wait()
+        {
+            wait_all();
+
+            if (failed.load(std::memory_order_acquire)) {
+#if MAYBE_RESULT_HAS_EXCEPTIONS
+                if (first_exception) {
+                    std::rethrow_exception(first_exception);
+                }
+#endif
+                return result<void, E>::err(*first_error);
+            }
+            return result<void, E>::ok();
+        }
+    };
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include "result.hpp"
+
+#include <type_traits>
+#include <utility>
+
+#if defined(__has_include)
+#if __cplusplus >= 201703L && __has_include(<optional>)
+#include <optional>
+#define MAYBE_RESULT_HAS_STD_OPTIONAL 1
+#endif
+#endif
+
+namespace maybe {
+    namespace internal {
+        /**
+         * `value` as an rvalue if `Like` is an rvalue, as a const lvalue otherwise.
+         */
+        template <typename Like, typename V>
+        auto forward_like(V& value) -> std::conditional_t<std::is_lvalue_reference<Like>::value,
+                                                          const V&,
+                                                          V&&>
+        {
+            return std::move(value);
+        }
+
+        template <template <typename> class Optional, typename T, typename E, typename O>
+        auto transpose_optional(O&& o) -> maybe::result<Optional<T>, E>
+        {
+            typedef maybe::result<Optional<T>, E> return_result_t;
+
+            if (!o) {
+                return return_result_t::ok(Optional<T>());
+            }
+            if (o->is_err()) {
+                return return_result_t(placeholder{}, forward_like<O>(o->err_value()));
+            }
+            return return_result_t::ok(Optional<T>(forward_like<O>(o->ok_value())));
+        }
+
+        template <template <typename> class Optional, typename T, typename E, typename R>
+        auto transpose_result(R&& r) -> Optional<maybe::result<T, E>>
+        {
+            if (r.is_err()) {
+                return Optional<maybe::result<T, E>>(
+                    maybe::result<T, E>(placeholder{}, forward_like<R>(r.err_value())));
+            }
+            if (!r.ok_value()) {
+                return Optional<maybe::result<T, E>>();
+            }
+            return Optional<maybe::result<T, E>>(
+                maybe::result<T, E>(forward_like<R>(*r.ok_value()), placeholder{}));
+        }
+    }
+
+    /**
+     * Converts an optional result into a result of optional: an empty optional becomes an ok
+     * empty optional, and an err value is forwarded.
+     *
+     * @param o std::experimental::optional<maybe::result<T, E>>
+     * @return maybe::result<std::experimental::optional<T>, E>
+     */
+    template <typename T, typename E>
+    auto transpose(std::experimental::optional<maybe::result<T, E>>&& o)
+        -> maybe::result<std::experimental::optional<T>, E>
+    {
+        return internal::transpose_optional<std::experimental::optional, T, E>(std::move(o));
+    }
+
+    template <typename T, typename E>
+    auto transpose(const std::experimental::optional<maybe::result<T, E>>& o)
+        -> maybe::result<std::experimental::optional<T>, E>
+    {
+        return internal::transpose_optional<std::experimental::optional, T, E>(o);
+    }
+
+    /**
+     * Converts a result of optional into an optional result: an ok empty optional becomes an
+     * empty optional, and an err value is forwarded.
+     *
+     * @param r maybe::result<std::experimental::optional<T>, E>
+     * @return std::experimental::optional<maybe::result<T, E>>
+     */
+    template <typename T, typename E>
+    auto transpose(maybe::result<std::experimental::optional<T>, E>&& r)
+        -> std::experimental::optional<maybe::result<T, E>>
+    {
+        return internal::transpose_result<std::experimental::optional, T, E>(std::move(r));
+    }
+
+    template <typename T, typename E>
+    auto transpose(const maybe::result<std::experimental::optional<T>, E>& r)
+        -> std::experimental::optional<maybe::result<T, E>>
+    {
+        return internal::transpose_result<std::experimental::optional, T, E>(r);
+    }
+
+#if MAYBE_RESULT_HAS_STD_OPTIONAL == 1
+
+    template <typename T, typename E>
+    auto transpose(std::optional<maybe::result<T, E>>&& o) -> maybe::result<std::optional<T>, E>
+    {
+        return internal::transpose_optional<std::optional, T, E>(std::move(o));
+    }
+
+    template <typename T, typename E>
+    auto transpose(const std::optional<maybe::result<T, E>>& o)
+        -> maybe::result<std::optional<T>, E>
+    {
+        return internal::transpose_optional<std::optional, T, E>(o);
+    }
+
+    template <typename T, typename E>
+    auto transpose(maybe::result<std::optional<T>, E>&& r) -> std::optional<maybe::result<T, E>>
+    {
+        return internal::transpose_result<std::optional, T, E>(std::move(r));
+    }
+
+    template <typename T, typename E>
+    auto transpose(const maybe::result<std::optional<T>, E>& r)
+        -> std::optional<maybe::result<T, E>>
+    {
+        return internal::transpose_result<std::optional, T, E>(r);
+    }
+
+#endif
+}
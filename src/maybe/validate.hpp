@@ -0,0 +1,61 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include "error_list.hpp"
+#include "result.hpp"
+#include "zip.hpp"
+
+#include <tuple>
+
+namespace maybe {
+    /**
+     * Combines ok values of all results into a tuple, or collects the err values of every failed
+     * result in positional order.
+     *
+     * Unlike `zip` and `and_then`, this does not stop at the first error, which makes it suitable
+     * for validating independent fields. Up to two errors are kept without allocating.
+     *
+     * Results passed as rvalues are moved from, others are copied.
+     *
+     * @param rs maybe::result<T, E>...
+     * @return maybe::result<std::tuple<T...>, maybe::error_list<E>>
+     */
+    template <typename R, typename... Rest>
+    auto validate(R&& r, Rest&&... rest)
+        -> maybe::result<std::tuple<internal::ok_type_t<R>, internal::ok_type_t<Rest>...>,
+                         error_list<internal::err_type_t<R>>>
+    {
+        static_assert(internal::all_err_types_are<internal::err_type_t<R>, Rest...>::value,
+                      "validate requires results with the same err type");
+
+        typedef maybe::result<std::tuple<internal::ok_type_t<R>, internal::ok_type_t<Rest>...>,
+                              error_list<internal::err_type_t<R>>>
+            return_result_t;
+
+        error_list<internal::err_type_t<R>> errors;
+
+        if (r.is_err()) {
+            errors.push_back(internal::forward_err<R>(r));
+        }
+        using expand = int[];
+        (void)expand{0,
+                     (rest.is_err() ? errors.push_back(internal::forward_err<Rest>(rest))
+                                    : void(),
+                      0)...};
+
+        if (!errors.empty()) {
+            return return_result_t::err(std::move(errors));
+        }
+        return return_result_t::ok(typename return_result_t::ok_type(
+            internal::forward_ok<R>(r), internal::forward_ok<Rest>(rest)...));
+    }
+}
@@ -0,0 +1,307 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include "async_result.hpp"
+#include "cancel_token.hpp"
+#include "result.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace maybe {
+    namespace internal {
+        /**
+         * Resolves `promise` with the first error to arrive, or with all values once every
+         * input is ok.
+         */
+        template <typename Values, typename E>
+        struct when_all_state final {
+            Values values;
+            std::atomic<std::size_t> remaining;
+            std::atomic<bool> failed{false};
+            cancel_token token;
+            async_promise<typename Values::ok_type, E> promise;
+
+            when_all_state(std::size_t count, cancel_token token)
+                : values(count), remaining(count), token(std::move(token))
+            {
+            }
+
+            void fail(E&& e)
+            {
+                if (!failed.exchange(true, std::memory_order_acq_rel)) {
+                    token.cancel();
+                    promise.set(maybe::result<typename Values::ok_type, E>(placeholder{},
+                                                                            std::move(e)));
+                }
+            }
+
+            void arrive()
+            {
+                if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1
+                    && !failed.load(std::memory_order_acquire)) {
+                    promise.set(maybe::result<typename Values::ok_type, E>::ok(values.take()));
+                }
+            }
+        };
+
+        template <typename... T>
+        struct tuple_values final {
+            typedef std::tuple<T...> ok_type;
+
+            std::tuple<std::experimental::optional<T>...> slots;
+
+            explicit tuple_values(std::size_t)
+            {
+            }
+
+            template <std::size_t I, typename V>
+            void put(V&& value)
+            {
+                std::get<I>(slots).emplace(std::forward<V>(value));
+            }
+
+            template <std::size_t... I>
+            ok_type take(std::index_sequence<I...>)
+            {
+                return ok_type(std::move(*std::get<I>(slots))...);
+            }
+
+            ok_type take()
+            {
+                return take(std::index_sequence_for<T...>{});
+            }
+        };
+
+        template <typename T>
+        struct vector_values final {
+            typedef std::vector<T> ok_type;
+
+            std::vector<std::experimental::optional<T>> slots;
+
+            explicit vector_values(std::size_t count) : slots(count)
+            {
+            }
+
+            template <typename V>
+            void put(std::size_t index, V&& value)
+            {
+                slots[index].emplace(std::forward<V>(value));
+            }
+
+            ok_type take()
+            {
+                ok_type out;
+                out.reserve(slots.size());
+                for (auto& slot : slots) {
+                    out.push_back(std::move(*slot));
+                }
+                return out;
+            }
+        };
+
+        template <std::size_t I, typename State, typename T, typename E>
+        void when_all_subscribe_one(const std::shared_ptr<State>& state, async_result<T, E>&& handle)
+        {
+            std::move(handle).on_ready([state](maybe::result<T, E>&& r) {
+                if (r.is_err()) {
+                    state->fail(std::move(r.err_value()));
+                } else {
+                    state->values.template put<I>(std::move(r.ok_value()));
+                }
+                state->arrive();
+            });
+        }
+
+        template <typename State, typename E, typename... T, std::size_t... I>
+        void when_all_subscribe_all(const std::shared_ptr<State>& state,
+                                    std::index_sequence<I...>,
+                                    async_result<T, E>&&... handles)
+        {
+            using expand = int[];
+            (void)expand{0, (when_all_subscribe_one<I>(state, std::move(handles)), 0)...};
+        }
+
+        template <typename T, typename E>
+        struct when_any_state final {
+            std::vector<std::experimental::optional<E>> errors;
+            std::atomic<std::size_t> remaining;
+            std::atomic<bool> done{false};
+            cancel_token token;
+            async_promise<T, std::vector<E>> promise;
+
+            when_any_state(std::size_t count, cancel_token token)
+                : errors(count), remaining(count), token(std::move(token))
+            {
+            }
+
+            void succeed(T&& value)
+            {
+                if (!done.exchange(true, std::memory_order_acq_rel)) {
+                    token.cancel();
+                    promise.set(maybe::result<T, std::vector<E>>::ok(std::move(value)));
+                }
+            }
+
+            void fail(std::size_t index, E&& e)
+            {
+                errors[index].emplace(std::move(e));
+                if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1
+                    && !done.exchange(true, std::memory_order_acq_rel)) {
+                    std::vector<E> all;
+                    all.reserve(errors.size());
+                    for (auto& error : errors) {
+                        all.push_back(std::move(*error));
+                    }
+                    promise.set(
+                        maybe::result<T, std::vector<E>>(placeholder{}, std::move(all)));
+                }
+            }
+        };
+    }
+
+    /**
+     * Waits for all async results and combines their ok values into a tuple.
+     *
+     * Resolves with the first err value to arrive, without waiting for the remaining results,
+     * and cancels `token` so that tasks observing it can stop early.
+     *
+     * @param token cancelled on the first error
+     * @param handles maybe::async_result<T, E>...
+     * @return maybe::async_result<std::tuple<T...>, E>
+     */
+    template <typename E, typename T, typename... Rest>
+    auto when_all(cancel_token token, async_result<T, E> first, async_result<Rest, E>... rest)
+        -> async_result<std::tuple<T, Rest...>, E>
+    {
+        typedef internal::when_all_state<internal::tuple_values<T, Rest...>, E> state_t;
+
+        auto state = std::make_shared<state_t>(1 + sizeof...(Rest), std::move(token));
+        auto out = state->promise.get_async_result();
+        internal::when_all_subscribe_all(state,
+                                         std::index_sequence_for<T, Rest...>{},
+                                         std::move(first),
+                                         std::move(rest)...);
+        return out;
+    }
+
+    template <typename E, typename T, typename... Rest>
+    auto when_all(async_result<T, E> first, async_result<Rest, E>... rest)
+        -> async_result<std::tuple<T, Rest...>, E>
+    {
+        return when_all(cancel_token(), std::move(first), std::move(rest)...);
+    }
+
+    /**
+     * Waits for all async results in a vector and collects their ok values in order.
+     *
+     * Resolves with the first err value to arrive and cancels `token`.
+     *
+     * @param token cancelled on the first error
+     * @param handles std::vector<maybe::async_result<T, E>>
+     * @return maybe::async_result<std::vector<T>, E>
+     */
+    template <typename T, typename E>
+    auto when_all(cancel_token token, std::vector<async_result<T, E>> handles)
+        -> async_result<std::vector<T>, E>
+    {
+        if (handles.empty()) {
+            return async_result<std::vector<T>, E>::ready(
+                maybe::result<std::vector<T>, E>::ok(std::vector<T>()));
+        }
+
+        typedef internal::when_all_state<internal::vector_values<T>, E> state_t;
+
+        auto state = std::make_shared<state_t>(handles.size(), std::move(token));
+        auto out = state->promise.get_async_result();
+        for (std::size_t i = 0; i < handles.size(); ++i) {
+            std::move(handles[i]).on_ready([state, i](maybe::result<T, E>&& r) {
+                if (r.is_err()) {
+                    state->fail(std::move(r.err_value()));
+                } else {
+                    state->values.put(i, std::move(r.ok_value()));
+                }
+                state->arrive();
+            });
+        }
+        return out;
+    }
+
+    template <typename T, typename E>
+    auto when_all(std::vector<async_result<T, E>> handles) -> async_result<std::vector<T>, E>
+    {
+        return when_all(cancel_token(), std::move(handles));
+    }
+
+    /**
+     * Resolves with the first ok value to arrive, or with all err values in positional order if
+     * every async result fails.
+     *
+     * Cancels `token` once an ok value arrives, since the remaining results are not needed.
+     *
+     * @param token cancelled on the first ok value
+     * @param handles std::vector<maybe::async_result<T, E>>
+     * @return maybe::async_result<T, std::vector<E>>
+     */
+    template <typename T, typename E>
+    auto when_any(cancel_token token, std::vector<async_result<T, E>> handles)
+        -> async_result<T, std::vector<E>>
+    {
+        if (handles.empty()) {
+            return async_result<T, std::vector<E>>::ready(
+                maybe::result<T, std::vector<E>>::err(std::vector<E>()));
+        }
+
+        typedef internal::when_any_state<T, E> state_t;
+
+        auto state = std::make_shared<state_t>(handles.size(), std::move(token));
+        auto out = state->promise.get_async_result();
+        for (std::size_t i = 0; i < handles.size(); ++i) {
+            std::move(handles[i]).on_ready([state, i](maybe::result<T, E>&& r) {
+                if (r.is_err()) {
+                    state->fail(i, std::move(r.err_value()));
+                } else {
+                    state->succeed(std::move(r.ok_value()));
+                }
+            });
+        }
+        return out;
+    }
+
+    template <typename T, typename E>
+    auto when_any(std::vector<async_result<T, E>> handles) -> async_result<T, std::vector<E>>
+    {
+        return when_any(cancel_token(), std::move(handles));
+    }
+
+    template <typename T, typename E, typename... Rest>
+    auto when_any(cancel_token token, async_result<T, E> first, Rest... rest)
+        -> async_result<T, std::vector<E>>
+    {
+        std::vector<async_result<T, E>> handles;
+        handles.reserve(1 + sizeof...(Rest));
+        handles.push_back(std::move(first));
+        using expand = int[];
+        (void)expand{0, (handles.push_back(std::move(rest)), 0)...};
+        return when_any(std::move(token), std::move(handles));
+    }
+
+    template <typename T, typename E, typename... Rest>
+    auto when_any(async_result<T, E> first, Rest... rest) -> async_result<T, std::vector<E>>
+    {
+        return when_any(cancel_token(), std::move(first), std::move(rest)...);
+    }
+}
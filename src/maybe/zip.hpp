@@ -0,0 +1,146 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+#pragma once
+
+#include "result.hpp"
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace maybe {
+    namespace internal {
+        template <typename R>
+        using ok_type_t = typename std::decay_t<R>::ok_type;
+
+        template <typename R>
+        using err_type_t = typename std::decay_t<R>::err_type;
+
+        template <typename E, typename... R>
+        struct all_err_types_are : std::true_type {
+        };
+
+        template <typename E, typename R, typename... Rest>
+        struct all_err_types_are<E, R, Rest...>
+            : std::integral_constant<bool,
+                                     std::is_same<E, err_type_t<R>>::value
+                                         && all_err_types_are<E, Rest...>::value> {
+        };
+
+        /**
+         * Ok value of `r`, moved out if `R` is an rvalue result and copied otherwise.
+         */
+        template <typename R, typename Result>
+        auto forward_ok(Result& r) -> std::conditional_t<std::is_lvalue_reference<R>::value,
+                                                         const ok_type_t<R>&,
+                                                         ok_type_t<R>&&>
+        {
+            return std::move(r.ok_value());
+        }
+
+        /**
+         * Err value of `r`, moved out if `R` is an rvalue result and copied otherwise.
+         */
+        template <typename R, typename Result>
+        auto forward_err(Result& r) -> std::conditional_t<std::is_lvalue_reference<R>::value,
+                                                          const err_type_t<R>&,
+                                                          err_type_t<R>&&>
+        {
+            return std::move(r.err_value());
+        }
+
+        template <typename Ret>
+        Ret first_err()
+        {
+            return Ret();
+        }
+
+        template <typename Ret, typename R, typename... Rest>
+        Ret first_err(R&& r, Rest&&... rest)
+        {
+            if (r.is_err()) {
+                return Ret::err(forward_err<R>(r));
+            }
+            return first_err<Ret>(std::forward<Rest>(rest)...);
+        }
+
+        /**
+         * Check if any result holds an err value, without branching per result.
+         */
+        template <typename... R>
+        bool any_err(const R&... rs) noexcept
+        {
+            bool errs = false;
+            using expand = bool[];
+            (void)expand{false, (errs |= rs.is_err())...};
+            return errs;
+        }
+    }
+
+    /**
+     * Combines ok values of all results into a tuple, or returns the first err value by position.
+     *
+     * Tags of all results are OR-ed together first, so the ok path takes a single branch.
+     * Results passed as rvalues are moved from, others are copied.
+     *
+     * @param rs maybe::result<T, E>...
+     * @return maybe::result<std::tuple<T...>, E>
+     */
+    template <typename R, typename... Rest>
+    auto zip(R&& r, Rest&&... rest)
+        -> maybe::result<std::tuple<internal::ok_type_t<R>, internal::ok_type_t<Rest>...>,
+                         internal::err_type_t<R>>
+    {
+        static_assert(internal::all_err_types_are<internal::err_type_t<R>, Rest...>::value,
+                      "zip requires results with the same err type");
+
+        typedef maybe::result<std::tuple<internal::ok_type_t<R>, internal::ok_type_t<Rest>...>,
+                              internal::err_type_t<R>>
+            return_result_t;
+
+        if (internal::any_err(r, rest...)) {
+            return internal::first_err<return_result_t>(std::forward<R>(r),
+                                                        std::forward<Rest>(rest)...);
+        }
+        return return_result_t::ok(typename return_result_t::ok_type(
+            internal::forward_ok<R>(r), internal::forward_ok<Rest>(rest)...));
+    }
+
+    /**
+     * Calls F with ok values of all results, or returns the first err value by position.
+     *
+     * This is `zip` followed by `map` with `std::apply`, without building the intermediate tuple.
+     * If F returns void, the result is `maybe::result<void, E>`.
+     *
+     * @param f F(T...) -> U
+     * @param rs maybe::result<T, E>...
+     * @return maybe::result<U, E>
+     */
+    template <typename F,
+              typename R,
+              typename... Rest,
+              typename U = typename std::result_of<F(internal::ok_type_t<R>,
+                                                     internal::ok_type_t<Rest>...)>::type>
+    auto zip_with(F f, R&& r, Rest&&... rest) -> maybe::result<U, internal::err_type_t<R>>
+    {
+        static_assert(internal::all_err_types_are<internal::err_type_t<R>, Rest...>::value,
+                      "zip_with requires results with the same err type");
+
+        typedef maybe::result<U, internal::err_type_t<R>> return_result_t;
+
+        if (internal::any_err(r, rest...)) {
+            return internal::first_err<return_result_t>(std::forward<R>(r),
+                                                        std::forward<Rest>(rest)...);
+        }
+        return internal::ok_of_call<return_result_t>::call(
+            f, internal::forward_ok<R>(r), internal::forward_ok<Rest>(rest)...);
+    }
+}
@@ -0,0 +1,94 @@
+#include "allocation_counter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+    thread_local std::size_t thread_allocations = 0;
+    thread_local std::size_t thread_deallocations = 0;
+
+    void* counted_allocate(std::size_t size) noexcept
+    {
+        ++thread_allocations;
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    void counted_deallocate(void* p) noexcept
+    {
+        if (p != nullptr) {
+            ++thread_deallocations;
+            std::free(p);
+        }
+    }
+}
+
+allocation_counter::allocation_counter() noexcept
+    : start_allocations(thread_allocations), start_deallocations(thread_deallocations)
+{
+}
+
+std::size_t allocation_counter::allocations() const noexcept
+{
+    return thread_allocations - start_allocations;
+}
+
+std::size_t allocation_counter::deallocations() const noexcept
+{
+    return thread_deallocations - start_deallocations;
+}
+
+void* operator new(std::size_t size)
+{
+    if (auto p = counted_allocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    if (auto p = counted_allocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return counted_allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return counted_allocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    counted_deallocate(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    counted_deallocate(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    counted_deallocate(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    counted_deallocate(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    counted_deallocate(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    counted_deallocate(p);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Counts calls to the global allocation functions made by the current thread while it is alive.
+ *
+ * The replacement `operator new` and `operator delete` are defined in allocation_counter.cpp and
+ * count into thread-local counters, so allocations of other threads, including the test
+ * runner's, do not disturb a measurement. Read the counts before using `REQUIRE`, which may
+ * allocate itself.
+ */
+class allocation_counter final {
+private:
+    std::size_t start_allocations;
+    std::size_t start_deallocations;
+
+public:
+    allocation_counter() noexcept;
+
+    allocation_counter(const allocation_counter&) = delete;
+    allocation_counter& operator=(const allocation_counter&) = delete;
+
+    /**
+     * @return number of allocations since construction
+     */
+    std::size_t allocations() const noexcept;
+
+    /**
+     * @return number of deallocations since construction
+     */
+    std::size_t deallocations() const noexcept;
+};
@@ -0,0 +1,180 @@
+#include "catch.hpp"
+
+#include <maybe/async_result.hpp>
+#include <memory>
+#include <string>
+#include <thread>
+
+using maybe::async_promise;
+using maybe::async_result;
+using maybe::result;
+
+namespace {
+    /**
+     * Executor that counts scheduled work and runs it immediately.
+     */
+    struct counting_executor final {
+        int scheduled = 0;
+
+        template <typename F>
+        void execute(F&& f)
+        {
+            ++scheduled;
+            f();
+        }
+    };
+
+    /**
+     * Executor that drops all work without running it.
+     */
+    struct dropping_executor final {
+        template <typename F>
+        void execute(F&&)
+        {
+        }
+    };
+
+    enum class ProducerError {
+        Failed,
+        Broken,
+    };
+}
+
+namespace maybe {
+    template <>
+    struct broken_promise_error<ProducerError> {
+        static ProducerError make()
+        {
+            return ProducerError::Broken;
+        }
+    };
+}
+
+TEST_CASE("async_result")
+{
+    SECTION("receives a value set on another thread")
+    {
+        async_promise<int, std::string> promise;
+        auto a = promise.get_async_result();
+
+        std::thread producer([promise]() mutable { promise.set(result<int, std::string>::ok(42)); });
+        auto r = std::move(a).get();
+        producer.join();
+
+        REQUIRE(r);
+        REQUIRE(42 == r.ok_value());
+    }
+
+    SECTION("runs continuations registered before the value is set")
+    {
+        async_promise<int, std::string> promise;
+        auto b = promise.get_async_result().map([](int v) { return std::to_string(v); });
+
+        REQUIRE(!b.is_ready());
+        promise.set(result<int, std::string>::ok(7));
+        REQUIRE(b.is_ready());
+        REQUIRE("7" == std::move(b).get().ok_value());
+    }
+
+    SECTION("chains map, and_then and map_err on an executor")
+    {
+        counting_executor executor;
+
+        auto r = async_result<int, std::string>::ready(result<int, std::string>::ok(2))
+                     .map(executor, [](int v) { return v * 10; })
+                     .and_then(executor,
+                               [](int v) { return result<std::string, std::string>::ok(std::to_string(v)); })
+                     .map_err(executor, [](std::string e) { return e.size(); })
+                     .get();
+
+        REQUIRE(r);
+        REQUIRE("20" == r.ok_value());
+        REQUIRE(2 == executor.scheduled);
+    }
+
+    SECTION("skips downstream continuations on error without scheduling them")
+    {
+        counting_executor executor;
+        bool called = false;
+
+        auto r = async_result<int, std::string>::ready(result<int, std::string>::err("failed"))
+                     .map(executor,
+                          [&called](int v) {
+                              called = true;
+                              return v;
+                          })
+                     .and_then(executor,
+                               [&called](int v) {
+                                   called = true;
+                                   return result<int, std::string>::ok(v);
+                               })
+                     .get();
+
+        REQUIRE(!r);
+        REQUIRE("failed" == r.err_value());
+        REQUIRE(!called);
+        REQUIRE(0 == executor.scheduled);
+    }
+
+    SECTION("chains functions returning async results")
+    {
+        async_promise<std::string, int> inner;
+
+        auto b = async_result<int, int>::ready(result<int, int>::ok(1))
+                     .and_then([&inner](int) { return inner.get_async_result(); });
+
+        REQUIRE(!b.is_ready());
+        inner.set(result<std::string, int>::ok("later"));
+        REQUIRE("later" == std::move(b).get().ok_value());
+    }
+
+    SECTION("supports void and move-only values")
+    {
+        auto r = async_result<void, int>::ready(result<void, int>::ok())
+                     .map([]() { return std::unique_ptr<int>(new int(3)); })
+                     .and_then([](std::unique_ptr<int> p) { return result<void, int>::err(*p); })
+                     .get();
+
+        REQUIRE(!r);
+        REQUIRE(3 == r.err_value());
+    }
+
+    SECTION("maps with a function returning void")
+    {
+        int seen = 0;
+        auto r = async_result<int, std::string>::ready(result<int, std::string>::ok(5))
+                     .map([&seen](int v) { seen = v; })
+                     .get();
+
+        REQUIRE(r);
+        REQUIRE(5 == seen);
+    }
+
+    SECTION("delivers the broken promise error when the promise is destroyed unset")
+    {
+        auto a = async_promise<int, ProducerError>().get_async_result();
+        REQUIRE(a.is_ready());
+        REQUIRE(ProducerError::Broken == std::move(a).get().err_value());
+
+        async_promise<int, ProducerError> promise;
+        auto copy = promise;
+        auto b = promise.get_async_result().map([](int v) { return v + 1; });
+        {
+            auto dropped = std::move(promise);
+        }
+        REQUIRE(!b.is_ready());
+        copy = async_promise<int, ProducerError>();
+        REQUIRE(ProducerError::Broken == std::move(b).get().err_value());
+    }
+
+    SECTION("completes continuations whose work an executor drops")
+    {
+        dropping_executor executor;
+        auto r = async_result<int, ProducerError>::ready(result<int, ProducerError>::ok(1))
+                     .map(executor, [](int v) { return v; })
+                     .get();
+
+        REQUIRE(!r);
+        REQUIRE(ProducerError::Broken == r.err_value());
+    }
+}
@@ -0,0 +1,132 @@
+#include "catch.hpp"
+
+#include <maybe/atomic_result.hpp>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using maybe::atomic_result;
+using maybe::result;
+
+TEST_CASE("atomic_result")
+{
+    SECTION("stores only the first result")
+    {
+        atomic_result<std::string, int> cell;
+        REQUIRE(!cell.is_ready());
+        REQUIRE(nullptr == cell.try_get());
+
+        REQUIRE(cell.set(result<std::string, int>::ok("first")));
+        REQUIRE(!cell.set(result<std::string, int>::err(1)));
+
+        REQUIRE(cell.is_ready());
+        REQUIRE("first" == cell.try_get()->ok_value());
+        REQUIRE("first" == cell.wait().ok_value());
+    }
+
+    SECTION("stores err values")
+    {
+        atomic_result<void, std::string> cell;
+        REQUIRE(cell.set(result<void, std::string>::err("bad")));
+        REQUIRE(cell.wait().is_err());
+        REQUIRE("bad" == cell.wait().err_value());
+    }
+
+    SECTION("does not call f once a result is stored")
+    {
+        atomic_result<int, int> cell;
+        cell.set(result<int, int>::ok(1));
+
+        bool called = false;
+        auto& r = cell.get_or_compute([&called]() {
+            called = true;
+            return result<int, int>::ok(2);
+        });
+        REQUIRE(1 == r.ok_value());
+        REQUIRE(!called);
+    }
+
+    SECTION("publishes to threads blocked in wait")
+    {
+        atomic_result<std::vector<int>, int> cell;
+        std::atomic<int> seen{0};
+
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 4; ++i) {
+            readers.emplace_back([&]() { seen += static_cast<int>(cell.wait().ok_value().size()); });
+        }
+        cell.set(result<std::vector<int>, int>::ok(std::vector<int>{1, 2, 3}));
+        for (auto& t : readers) {
+            t.join();
+        }
+
+        REQUIRE(12 == seen.load());
+    }
+
+    SECTION("runs one initializer for concurrent get_or_compute calls")
+    {
+        atomic_result<int, std::string> cell;
+        std::atomic<int> calls{0};
+        std::atomic<int> sum{0};
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 8; ++i) {
+            threads.emplace_back([&]() {
+                auto& r = cell.get_or_compute([&calls]() {
+                    ++calls;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                    return result<int, std::string>::ok(42);
+                });
+                sum += r.ok_value();
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        REQUIRE(1 == calls.load());
+        REQUIRE(8 * 42 == sum.load());
+    }
+
+    SECTION("lets a waiting caller compute the result when f throws")
+    {
+        atomic_result<int, std::string> cell;
+        std::atomic<bool> computing{false};
+        std::atomic<bool> release{false};
+        bool thrown = false;
+
+        std::thread first([&]() {
+            try {
+                cell.get_or_compute([&]() -> result<int, std::string> {
+                    computing = true;
+                    while (!release.load()) {
+                        std::this_thread::yield();
+                    }
+                    throw std::runtime_error("failed");
+                });
+            } catch (const std::runtime_error&) {
+                thrown = true;
+            }
+        });
+        while (!computing.load()) {
+            std::this_thread::yield();
+        }
+
+        int calls = 0;
+        std::thread second([&]() {
+            cell.get_or_compute([&calls]() {
+                ++calls;
+                return result<int, std::string>::ok(7);
+            });
+        });
+        release = true;
+        first.join();
+        second.join();
+
+        REQUIRE(thrown);
+        REQUIRE(1 == calls);
+        REQUIRE(7 == cell.wait().ok_value());
+    }
+}
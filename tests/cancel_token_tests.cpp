@@ -0,0 +1,144 @@
+#include "catch.hpp"
+
+#include <maybe/async_result.hpp>
+#include <maybe/cancel_token.hpp>
+#include <maybe/executor.hpp>
+#include <string>
+
+using maybe::async_result;
+using maybe::cancel_reason;
+using maybe::cancel_token;
+using maybe::result;
+
+namespace {
+    enum class FetchError {
+        NotFound,
+        Cancelled,
+        TimedOut,
+    };
+
+    struct counting_executor {
+        int& scheduled;
+
+        template <typename F>
+        void execute(F&& f)
+        {
+            ++scheduled;
+            f();
+        }
+    };
+}
+
+namespace maybe {
+    template <>
+    struct cancel_error<FetchError> {
+        static FetchError make(cancel_reason reason)
+        {
+            return reason == cancel_reason::cancelled ? FetchError::Cancelled : FetchError::TimedOut;
+        }
+    };
+}
+
+TEST_CASE("cancel_token")
+{
+    SECTION("runs the next stage while the token is live")
+    {
+        cancel_token token;
+
+        auto r = result<int, FetchError>::ok(1).and_then(
+            token, [](int v) { return result<std::string, FetchError>::ok(std::to_string(v)); });
+        REQUIRE(r);
+        REQUIRE("1" == r.ok_value());
+        REQUIRE(!token.is_cancelled());
+    }
+
+    SECTION("does not run the next stage once cancelled")
+    {
+        cancel_token token;
+        auto copy = token;
+        copy.cancel();
+
+        bool called = false;
+        auto r = result<void, FetchError>::ok().and_then(token, [&called]() {
+            called = true;
+            return result<int, FetchError>::ok(1);
+        });
+        REQUIRE(!r);
+        REQUIRE(FetchError::Cancelled == r.err_value());
+        REQUIRE(!called);
+        REQUIRE(cancel_reason::cancelled == token.reason());
+    }
+
+    SECTION("forwards an existing error rather than the cancel reason")
+    {
+        cancel_token token;
+        token.cancel();
+
+        auto r = result<int, FetchError>::err(FetchError::NotFound).and_then(
+            token, [](int v) { return result<int, FetchError>::ok(v); });
+        REQUIRE(!r);
+        REQUIRE(FetchError::NotFound == r.err_value());
+    }
+
+    SECTION("expires once the deadline passes")
+    {
+        auto expired = cancel_token::with_deadline(std::chrono::steady_clock::now()
+                                                   - std::chrono::milliseconds(1));
+        auto live = cancel_token::with_timeout(std::chrono::hours(1));
+
+        REQUIRE(expired.is_cancelled());
+        REQUIRE(cancel_reason::deadline_exceeded == expired.reason());
+        REQUIRE(!live.is_cancelled());
+
+        auto r = result<int, FetchError>::ok(1).and_then(
+            expired, [](int v) { return result<int, FetchError>::ok(v); });
+        REQUIRE(!r);
+        REQUIRE(FetchError::TimedOut == r.err_value());
+    }
+
+    SECTION("converts the cancel reason with the error constructor by default")
+    {
+        cancel_token token;
+        token.cancel();
+
+        auto r = result<int, cancel_reason>::ok(1).and_then(
+            token, [](int v) { return result<int, cancel_reason>::ok(v); });
+        REQUIRE(!r);
+        REQUIRE(cancel_reason::cancelled == r.err_value());
+    }
+
+    SECTION("skips async stages without scheduling them once cancelled")
+    {
+        cancel_token token;
+        token.cancel();
+
+        int scheduled = 0;
+        counting_executor executor{scheduled};
+
+        auto r = async_result<int, FetchError>::ready(result<int, FetchError>::ok(1))
+                     .and_then(executor, token, [](int v) { return result<int, FetchError>::ok(v); })
+                     .get();
+        REQUIRE(!r);
+        REQUIRE(FetchError::Cancelled == r.err_value());
+        REQUIRE(0 == scheduled);
+    }
+
+    SECTION("skips submitted tasks once cancelled")
+    {
+        maybe::executor executor(1);
+        cancel_token token;
+        token.cancel();
+
+        bool called = false;
+        auto r = executor
+                     .submit(token,
+                             [&called]() {
+                                 called = true;
+                                 return result<int, FetchError>::ok(1);
+                             })
+                     .get();
+        REQUIRE(!r);
+        REQUIRE(FetchError::Cancelled == r.err_value());
+        REQUIRE(!called);
+    }
+}
@@ -0,0 +1,167 @@
+#include "catch.hpp"
+
+#include <maybe/channel.hpp>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using maybe::channel;
+using maybe::result;
+
+TEST_CASE("channel")
+{
+    typedef result<int, std::string> item_t;
+
+    SECTION("delivers values in order")
+    {
+        channel<item_t> ch(4);
+        REQUIRE(4 == ch.capacity());
+
+        REQUIRE(ch.try_push(item_t::ok(1)));
+        REQUIRE(ch.try_push(item_t::err("bad")));
+        REQUIRE(ch.try_push(item_t::ok(3)));
+
+        auto first = ch.try_pop();
+        REQUIRE(first);
+        REQUIRE(1 == first->ok_value());
+
+        auto second = ch.try_pop();
+        REQUIRE(second);
+        REQUIRE("bad" == second->err_value());
+
+        REQUIRE(3 == ch.pop().ok_value());
+        REQUIRE(!ch.try_pop());
+    }
+
+    SECTION("rounds capacity up and rejects pushes while full")
+    {
+        channel<item_t> ch(3);
+        REQUIRE(4 == ch.capacity());
+
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(ch.try_push(item_t::ok(i)));
+        }
+        REQUIRE(!ch.try_push(item_t::ok(4)));
+
+        REQUIRE(0 == ch.pop().ok_value());
+        REQUIRE(ch.try_push(item_t::ok(4)));
+    }
+
+    SECTION("pushes and pops in batches")
+    {
+        channel<item_t> ch(8);
+
+        std::vector<item_t> in;
+        for (int i = 0; i < 10; ++i) {
+            in.push_back(item_t::ok(i));
+        }
+        REQUIRE(8 == ch.push_n(in.begin(), in.size()));
+
+        std::vector<item_t> out(5, item_t::ok(-1));
+        REQUIRE(5 == ch.pop_n(out.begin(), out.size()));
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE(i == out[i].ok_value());
+        }
+
+        REQUIRE(2 == ch.push_n(in.begin() + 8, 2));
+        REQUIRE(5 == ch.pop_n(out.begin(), out.size()));
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE(i + 5 == out[i].ok_value());
+        }
+        REQUIRE(0 == ch.pop_n(out.begin(), out.size()));
+    }
+
+    SECTION("delivers the terminal error after draining a closed channel")
+    {
+        channel<item_t> ch(4);
+        REQUIRE(ch.try_push(item_t::ok(1)));
+
+        REQUIRE(ch.close("done"));
+        REQUIRE(!ch.close("again"));
+        REQUIRE(ch.is_closed());
+        REQUIRE(!ch.try_push(item_t::ok(2)));
+        REQUIRE(!ch.push(item_t::ok(2)));
+
+        REQUIRE(1 == ch.pop().ok_value());
+        REQUIRE("done" == ch.pop().err_value());
+        REQUIRE("done" == ch.pop().err_value());
+    }
+
+    SECTION("wakes blocked producers and consumers")
+    {
+        channel<item_t> full(2);
+        REQUIRE(full.try_push(item_t::ok(0)));
+        REQUIRE(full.try_push(item_t::ok(1)));
+        bool pushed = false;
+        std::thread producer([&]() { pushed = full.push(item_t::ok(2)); });
+        REQUIRE(0 == full.pop().ok_value());
+        producer.join();
+        REQUIRE(pushed);
+        REQUIRE(1 == full.pop().ok_value());
+        REQUIRE(2 == full.pop().ok_value());
+
+        channel<item_t> empty(2);
+        std::string error;
+        std::thread consumer([&]() { error = empty.pop().err_value(); });
+        empty.close("done");
+        consumer.join();
+        REQUIRE("done" == error);
+    }
+
+    SECTION("moves every value exactly once between many producers and consumers")
+    {
+        const int producers = 4;
+        const int consumers = 4;
+        const int per_producer = 20000;
+
+        channel<item_t> ch(64);
+        std::atomic<long long> sum{0};
+        std::atomic<int> errors{0};
+        std::atomic<int> done_producers{0};
+
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&, p]() {
+                std::vector<item_t> batch;
+                for (int i = 0; i < per_producer; ++i) {
+                    if (i % 100 == 0) {
+                        ch.push(item_t::err("odd"));
+                    }
+                    batch.push_back(item_t::ok(p * per_producer + i));
+                    if (batch.size() == 7 || i + 1 == per_producer) {
+                        std::size_t sent = 0;
+                        while (sent < batch.size()) {
+                            sent += ch.push_n(batch.begin() + sent, batch.size() - sent);
+                        }
+                        batch.clear();
+                    }
+                }
+                if (done_producers.fetch_add(1) + 1 == producers) {
+                    ch.close("closed");
+                }
+            });
+        }
+        for (int c = 0; c < consumers; ++c) {
+            threads.emplace_back([&]() {
+                for (;;) {
+                    auto r = ch.pop();
+                    if (r.is_ok()) {
+                        sum += r.ok_value();
+                    } else if (r.err_value() == "odd") {
+                        ++errors;
+                    } else {
+                        break;
+                    }
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        const long long n = producers * per_producer;
+        REQUIRE(n * (n - 1) / 2 == sum.load());
+        REQUIRE(producers * per_producer / 100 == errors.load());
+    }
+}
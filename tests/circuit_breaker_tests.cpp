@@ -0,0 +1,247 @@
+#include "catch.hpp"
+
+#include <maybe/circuit_breaker.hpp>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using maybe::circuit_breaker_options;
+using maybe::circuit_state;
+using maybe::result;
+
+namespace {
+    /**
+     * Clock that only moves when a test advances it.
+     */
+    struct manual_clock final {
+        static std::atomic<std::chrono::steady_clock::rep> ticks;
+
+        static std::chrono::steady_clock::time_point now() noexcept
+        {
+            return std::chrono::steady_clock::time_point(
+                std::chrono::steady_clock::duration(ticks.load()));
+        }
+
+        static void advance(std::chrono::steady_clock::duration by) noexcept
+        {
+            ticks += by.count();
+        }
+    };
+
+    std::atomic<std::chrono::steady_clock::rep> manual_clock::ticks{0};
+
+    template <typename E>
+    using circuit_breaker = maybe::circuit_breaker<E, manual_clock>;
+
+    circuit_breaker_options test_options()
+    {
+        circuit_breaker_options options;
+        options.window = std::chrono::seconds(60);
+        options.buckets = 6;
+        options.min_calls = 4;
+        options.failure_ratio = 0.5;
+        options.open_duration = std::chrono::milliseconds(20);
+        options.half_open_probes = 2;
+        return options;
+    }
+
+    result<int, std::string> fail()
+    {
+        return result<int, std::string>::err("down");
+    }
+
+    result<int, std::string> succeed()
+    {
+        return result<int, std::string>::ok(1);
+    }
+}
+
+TEST_CASE("circuit_breaker")
+{
+    SECTION("stays closed below the minimum number of calls")
+    {
+        circuit_breaker<std::string> breaker("open", test_options());
+        for (int i = 0; i < 3; ++i) {
+            REQUIRE("down" == breaker.call(fail).err_value());
+        }
+        REQUIRE(circuit_state::closed == breaker.state());
+    }
+
+    SECTION("does not count buckets from an earlier lap of the window")
+    {
+        circuit_breaker<std::string> breaker("open", test_options());
+        for (int i = 0; i < 3; ++i) {
+            breaker.call(fail);
+        }
+        // 2^16 buckets of 10 seconds later, the failures above are long out of the window.
+        manual_clock::advance(std::chrono::seconds(10) * 65536);
+        breaker.call(fail);
+        REQUIRE(circuit_state::closed == breaker.state());
+    }
+
+    SECTION("stays closed below the failure ratio")
+    {
+        circuit_breaker<std::string> breaker("open", test_options());
+        for (int i = 0; i < 10; ++i) {
+            breaker.call(succeed);
+            breaker.call(succeed);
+            breaker.call(fail);
+        }
+        REQUIRE(circuit_state::closed == breaker.state());
+    }
+
+    SECTION("opens and stops calling the dependency")
+    {
+        circuit_breaker<std::string> breaker("open", test_options());
+        breaker.call(succeed);
+        breaker.call(fail);
+        breaker.call(succeed);
+        breaker.call(fail);
+        REQUIRE(circuit_state::open == breaker.state());
+
+        int calls = 0;
+        auto r = breaker.call([&calls]() {
+            ++calls;
+            return result<void, std::string>::ok();
+        });
+        REQUIRE(!r);
+        REQUIRE("open" == r.err_value());
+        REQUIRE(0 == calls);
+    }
+
+    SECTION("closes after successful probes")
+    {
+        circuit_breaker<std::string> breaker("open", test_options());
+        for (int i = 0; i < 4; ++i) {
+            breaker.call(fail);
+        }
+        REQUIRE(circuit_state::open == breaker.state());
+
+        manual_clock::advance(std::chrono::milliseconds(30));
+        REQUIRE(breaker.call(succeed));
+        REQUIRE(circuit_state::half_open == breaker.state());
+        REQUIRE(breaker.call(succeed));
+        REQUIRE(circuit_state::closed == breaker.state());
+
+        // The window starts empty after closing.
+        breaker.call(fail);
+        REQUIRE(circuit_state::closed == breaker.state());
+    }
+
+    SECTION("reopens when a probe fails")
+    {
+        circuit_breaker<std::string> breaker("open", test_options());
+        for (int i = 0; i < 4; ++i) {
+            breaker.call(fail);
+        }
+
+        manual_clock::advance(std::chrono::milliseconds(30));
+        REQUIRE("down" == breaker.call(fail).err_value());
+        REQUIRE(circuit_state::open == breaker.state());
+        REQUIRE("open" == breaker.call(succeed).err_value());
+    }
+
+    SECTION("lets only the configured number of probes through")
+    {
+        auto options = test_options();
+        options.half_open_probes = 3;
+        circuit_breaker<std::string> breaker("open", options);
+        for (int i = 0; i < 4; ++i) {
+            breaker.call(fail);
+        }
+        manual_clock::advance(std::chrono::milliseconds(30));
+
+        std::atomic<int> calls{0};
+        std::atomic<int> rejected{0};
+        std::atomic<bool> release{false};
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 8; ++i) {
+            threads.emplace_back([&]() {
+                auto r = breaker.call([&]() {
+                    ++calls;
+                    while (!release.load()) {
+                        std::this_thread::yield();
+                    }
+                    return succeed();
+                });
+                if (!r) {
+                    ++rejected;
+                }
+            });
+        }
+        // Every thread either blocks in a probe or is turned away.
+        while (calls.load() + rejected.load() < 8) {
+            std::this_thread::yield();
+        }
+        release = true;
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        REQUIRE(3 == calls.load());
+        REQUIRE(circuit_state::closed == breaker.state());
+    }
+
+    SECTION("keeps the open time of the first trip when a slow call fails late")
+    {
+        auto options = test_options();
+        options.open_duration = std::chrono::milliseconds(300);
+        circuit_breaker<std::string> breaker("open", options);
+
+        std::atomic<bool> started{false};
+        std::atomic<bool> release{false};
+        std::thread slow([&]() {
+            breaker.call([&]() {
+                started = true;
+                while (!release.load()) {
+                    std::this_thread::yield();
+                }
+                return fail();
+            });
+        });
+        while (!started.load()) {
+            std::this_thread::yield();
+        }
+        for (int i = 0; i < 4; ++i) {
+            breaker.call(fail);
+        }
+        REQUIRE(circuit_state::open == breaker.state());
+
+        manual_clock::advance(std::chrono::milliseconds(150));
+        release = true;
+        slow.join();
+        REQUIRE(circuit_state::open == breaker.state());
+
+        // Past the open duration of the first trip, but not of one restarted by the slow call.
+        manual_clock::advance(std::chrono::milliseconds(225));
+        int calls = 0;
+        REQUIRE(breaker.call([&calls]() {
+            ++calls;
+            return succeed();
+        }));
+        REQUIRE(1 == calls);
+        REQUIRE(circuit_state::half_open == breaker.state());
+    }
+
+    SECTION("counts calls from many threads")
+    {
+        auto options = test_options();
+        options.min_calls = 4000;
+        circuit_breaker<std::string> breaker("open", options);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&]() {
+                for (int i = 0; i < 1000; ++i) {
+                    breaker.call(i % 2 == 1 ? fail : succeed);
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        REQUIRE(circuit_state::open == breaker.state());
+    }
+}
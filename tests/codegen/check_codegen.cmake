@@ -0,0 +1,100 @@
+#
+# Copyright 2016 TRAFI
+#
+# Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+# http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+# http://opensource.org/licenses/MIT>, at your option. This file may not be
+# copied, modified, or distributed except according to those terms.
+#
+
+# Checks the optimized assembly of one function in snippets.cpp. Run with cmake -P and:
+#
+#   COMPILER          C++ compiler, GCC or Clang
+#   SOURCE            snippets.cpp
+#   INCLUDES          ;-separated include directories
+#   OUTPUT            assembly file to write
+#   FUNCTION          extern "C" function to check
+#   MAX_INSTRUCTIONS  instruction budget of the function's hot part
+#   NO_EXCEPTIONS     compile with -fno-exceptions, optional
+#
+# The hot part is the function up to its first section switch, which is where GCC and Clang
+# move cold blocks. The function fails the check if it constructs or throws an exception
+# inline, or if its hot part calls out, spills to the stack or exceeds its budget. Without
+# exceptions it also fails if the file has exception tables or the function a personality.
+
+foreach(var COMPILER SOURCE OUTPUT FUNCTION MAX_INSTRUCTIONS)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "${var} is not set")
+    endif()
+endforeach()
+
+set(flags "")
+if(NO_EXCEPTIONS)
+    set(flags -fno-exceptions)
+endif()
+
+set(include_flags "")
+foreach(dir ${INCLUDES})
+    if(dir)
+        list(APPEND include_flags "-I${dir}")
+    endif()
+endforeach()
+
+execute_process(
+        COMMAND ${COMPILER} -std=c++14 -O2 -S -fno-asynchronous-unwind-tables ${flags}
+                ${include_flags}
+                ${SOURCE} -o ${OUTPUT}
+        RESULT_VARIABLE status
+        ERROR_VARIABLE errors)
+if(NOT status EQUAL 0)
+    message(FATAL_ERROR "compiling ${SOURCE} failed:\n${errors}")
+endif()
+
+file(STRINGS ${OUTPUT} lines)
+
+set(inside FALSE)
+set(hot TRUE)
+set(found FALSE)
+set(instructions 0)
+set(failures "")
+foreach(line IN LISTS lines)
+    if(line STREQUAL "${FUNCTION}:")
+        set(inside TRUE)
+        set(found TRUE)
+    elseif(inside AND line MATCHES "^[ \t]*\\.size[ \t]+${FUNCTION},")
+        break()
+    elseif(inside)
+        if(line MATCHES "bad_optional_access|__cxa_throw|__cxa_allocate_exception")
+            list(APPEND failures "throws inline: ${line}")
+        endif()
+        if(NO_EXCEPTIONS AND line MATCHES "\\.cfi_personality|\\.cfi_lsda")
+            list(APPEND failures "unwinds without exceptions: ${line}")
+        endif()
+        if(line MATCHES "^[ \t]*\\.section")
+            set(hot FALSE)
+        elseif(hot AND line MATCHES "^[ \t]+[a-z]")
+            math(EXPR instructions "${instructions} + 1")
+            if(line MATCHES "^[ \t]+call")
+                list(APPEND failures "calls on the hot path: ${line}")
+            endif()
+            if(line MATCHES "\\(%[re]?sp\\)|\\(%[re]?bp\\)|^[ \t]+push")
+                list(APPEND failures "spills on the hot path: ${line}")
+            endif()
+        endif()
+    endif()
+endforeach()
+
+if(NO_EXCEPTIONS AND lines MATCHES "gcc_except_table")
+    list(APPEND failures "exception tables without exceptions")
+endif()
+if(NOT found)
+    message(FATAL_ERROR "${FUNCTION} not found in ${OUTPUT}")
+endif()
+if(instructions GREATER MAX_INSTRUCTIONS)
+    list(APPEND failures "${instructions} instructions, budget is ${MAX_INSTRUCTIONS}")
+endif()
+if(failures)
+    string(REPLACE ";" "\n  " failures "${failures}")
+    message(FATAL_ERROR "${FUNCTION}:\n  ${failures}")
+endif()
+message(STATUS "${FUNCTION}: ${instructions} instructions")
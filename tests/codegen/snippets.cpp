@@ -0,0 +1,84 @@
+/*
+ * Copyright 2016 TRAFI
+ *
+ * Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+ * http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+ * http://opensource.org/licenses/MIT>, at your option. This file may not be
+ * copied, modified, or distributed except according to those terms.
+ *
+ */
+
+// Snippets compiled to assembly by check_codegen.cmake. Each function is checked for calls into
+// the bad_optional_access path, stack spills and its instruction count, so keep them extern "C"
+// and free of anything the checks do not expect.
+
+#include <maybe/result.hpp>
+
+using maybe::result;
+
+namespace {
+    inline result<int, int> parse(int x)
+    {
+        return x < 0 ? result<int, int>::err(x) : result<int, int>::ok(x);
+    }
+
+    inline result<int, int> half(int x)
+    {
+        return x % 2 == 0 ? result<int, int>::ok(x / 2) : result<int, int>::err(x);
+    }
+}
+
+extern "C" int codegen_checked_ok_value(int x)
+{
+    auto r = parse(x);
+    return r.is_ok() ? r.ok_value() : -1;
+}
+
+extern "C" int codegen_ok_value_or(int x)
+{
+    return parse(x).ok_value_or(-1);
+}
+
+extern "C" int codegen_map_chain(int x)
+{
+    return parse(x)
+        .map([](int v) { return v + 1; })
+        .map([](int v) { return v * 3; })
+        .map([](int v) { return v - 2; })
+        .ok_value_or(-1);
+}
+
+extern "C" int codegen_and_then(int x)
+{
+    return parse(x).and_then(half).and_then(half).ok_value_or(-1);
+}
+
+extern "C" int codegen_try(int x)
+{
+    auto a = parse(x);
+    if (!a) {
+        return a.err_value();
+    }
+    auto b = half(a.ok_value());
+    if (!b) {
+        return b.err_value();
+    }
+    return b.ok_value() + 1;
+}
+
+extern "C" int codegen_checked_ref(const result<int, int>* r)
+{
+    return r->is_ok() ? r->ok_value() : r->is_err() ? r->err_value() : 0;
+}
+
+extern "C" int codegen_map_ref(const result<int, int>* r)
+{
+    auto copy = *r;
+    return copy.map([](int v) { return v + 1; }).ok_value_or(-1);
+}
+
+extern "C" int codegen_and_then_ref(const result<int, int>* r)
+{
+    auto copy = *r;
+    return copy.and_then(half).ok_value_or(-1);
+}
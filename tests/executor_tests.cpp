@@ -0,0 +1,130 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <maybe/executor.hpp>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using maybe::async_result;
+using maybe::result;
+
+namespace {
+    void spawn_tree(maybe::executor& executor, std::atomic<int>& done, int depth)
+    {
+        ++done;
+        if (depth == 0) {
+            return;
+        }
+        for (int i = 0; i < 2; ++i) {
+            executor.execute([&executor, &done, depth]() { spawn_tree(executor, done, depth - 1); });
+        }
+    }
+}
+
+TEST_CASE("executor")
+{
+    SECTION("runs submitted functions and returns their results")
+    {
+        maybe::executor executor(4);
+
+        std::vector<async_result<int, std::string>> results;
+        for (int i = 0; i < 1000; ++i) {
+            results.push_back(executor.submit([i]() {
+                return i % 3 == 0 ? result<int, std::string>::err(std::to_string(i))
+                                  : result<int, std::string>::ok(i);
+            }));
+        }
+
+        int oks = 0;
+        for (int i = 0; i < 1000; ++i) {
+            auto r = std::move(results[i]).get();
+            if (r) {
+                REQUIRE(i == r.ok_value());
+                ++oks;
+            } else {
+                REQUIRE(std::to_string(i) == r.err_value());
+            }
+        }
+        REQUIRE(666 == oks);
+    }
+
+    SECTION("runs continuations on worker threads")
+    {
+        maybe::executor executor(2);
+
+        auto r = executor.submit([]() { return result<int, std::string>::ok(20); })
+                     .map(executor, [](int v) { return v + 1; })
+                     .and_then(executor, [](int v) { return result<int, std::string>::ok(v * 2); })
+                     .get();
+
+        REQUIRE(r);
+        REQUIRE(42 == r.ok_value());
+    }
+
+    SECTION("runs tasks spawned from worker threads")
+    {
+        std::atomic<int> done{0};
+        maybe::executor executor(3);
+
+        executor.execute([&executor, &done]() { spawn_tree(executor, done, 10); });
+        while (done.load() != 2047) {
+            std::this_thread::yield();
+        }
+
+        REQUIRE(2047 == done.load());
+    }
+
+    SECTION("runs all queued work before destruction")
+    {
+        std::atomic<int> done{0};
+        {
+            maybe::executor executor(2);
+            for (int i = 0; i < 100; ++i) {
+                executor.execute([&done, &executor]() {
+                    executor.execute([&done]() { ++done; });
+                    ++done;
+                });
+            }
+        }
+        REQUIRE(200 == done.load());
+    }
+
+    SECTION("runs delayed tasks in deadline order once due")
+    {
+        maybe::executor executor(1);
+        std::mutex mutex;
+        std::vector<int> order;
+        std::atomic<int> done{0};
+
+        auto start = std::chrono::steady_clock::now();
+        executor.execute_after(std::chrono::milliseconds(30), [&]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(2);
+            ++done;
+        });
+        executor.execute_after(std::chrono::milliseconds(10), [&]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(1);
+            ++done;
+        });
+        while (done.load() != 2) {
+            std::this_thread::yield();
+        }
+
+        REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(30));
+        REQUIRE((std::vector<int>{1, 2}) == order);
+    }
+
+    SECTION("runs pending delayed tasks before destruction")
+    {
+        std::atomic<int> done{0};
+        {
+            maybe::executor executor(1);
+            executor.execute_after(std::chrono::hours(1), [&done]() { ++done; });
+        }
+        REQUIRE(1 == done.load());
+    }
+}
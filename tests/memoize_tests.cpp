@@ -0,0 +1,188 @@
+#include "catch.hpp"
+
+#include <maybe/memoize.hpp>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using maybe::memoize;
+using maybe::memoize_policy;
+using maybe::result;
+
+TEST_CASE("memoize")
+{
+    SECTION("caches ok results by arguments")
+    {
+        int calls = 0;
+        auto square = memoize<int>(
+            [&calls](int x) {
+                ++calls;
+                return result<int, std::string>::ok(x * x);
+            },
+            16);
+
+        REQUIRE(9 == square(3).ok_value());
+        REQUIRE(9 == square(3).ok_value());
+        REQUIRE(16 == square(4).ok_value());
+        REQUIRE(2 == calls);
+
+        auto stats = square.stats();
+        REQUIRE(1 == stats.hits);
+        REQUIRE(2 == stats.misses);
+    }
+
+    SECTION("keys on every argument")
+    {
+        int calls = 0;
+        auto join = memoize<std::string, int>(
+            [&calls](const std::string& s, int n) {
+                ++calls;
+                return result<std::string, int>::ok(s + std::to_string(n));
+            },
+            16);
+
+        REQUIRE("a1" == join("a", 1).ok_value());
+        REQUIRE("a2" == join("a", 2).ok_value());
+        REQUIRE("a1" == join("a", 1).ok_value());
+        REQUIRE(2 == calls);
+    }
+
+    SECTION("expires err results after their own TTL")
+    {
+        memoize_policy policy;
+        policy.err_ttl = std::chrono::steady_clock::duration::zero();
+
+        int calls = 0;
+        auto lookup = memoize<int>(
+            [&calls](int x) {
+                ++calls;
+                return x < 0 ? result<int, std::string>::err("negative")
+                             : result<int, std::string>::ok(x);
+            },
+            16,
+            policy);
+
+        REQUIRE("negative" == lookup(-1).err_value());
+        REQUIRE("negative" == lookup(-1).err_value());
+        REQUIRE(1 == lookup(1).ok_value());
+        REQUIRE(1 == lookup(1).ok_value());
+        REQUIRE(3 == calls);
+        REQUIRE(1 == lookup.stats().expirations);
+    }
+
+    SECTION("evicts least recently used entries per kind")
+    {
+        memoize_policy policy;
+        policy.shards = 1;
+        policy.err_capacity = 1;
+
+        int calls = 0;
+        auto lookup = memoize<int>(
+            [&calls](int x) {
+                ++calls;
+                return x < 0 ? result<int, int>::err(x) : result<int, int>::ok(x);
+            },
+            2,
+            policy);
+
+        lookup(1);
+        lookup(2);
+        lookup(1);
+        lookup(-1);
+        lookup(3);
+        REQUIRE(4 == calls);
+
+        lookup(1);
+        REQUIRE(4 == calls);
+        lookup(2);
+        REQUIRE(5 == calls);
+
+        lookup(-2);
+        lookup(-1);
+        REQUIRE(7 == calls);
+        REQUIRE(4 == lookup.stats().evictions);
+    }
+
+    SECTION("shares the cache between copies")
+    {
+        int calls = 0;
+        auto lookup = memoize<int>(
+            [&calls](int x) {
+                ++calls;
+                return result<int, int>::ok(x);
+            },
+            16);
+        auto copy = lookup;
+
+        auto r = result<int, int>::ok(5).and_then(lookup);
+        REQUIRE(5 == r.ok_value());
+        REQUIRE(5 == copy(5).ok_value());
+        REQUIRE(1 == calls);
+    }
+
+    SECTION("calls f once for concurrent misses on the same arguments")
+    {
+        std::atomic<int> calls{0};
+        auto slow = memoize<int>(
+            [&calls](int x) {
+                ++calls;
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                return result<int, int>::ok(x + 1);
+            },
+            16);
+
+        std::atomic<int> sum{0};
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 8; ++i) {
+            threads.emplace_back([&]() { sum += slow(1).ok_value(); });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        REQUIRE(1 == calls.load());
+        REQUIRE(16 == sum.load());
+
+        auto stats = slow.stats();
+        REQUIRE(1 == stats.misses);
+        REQUIRE(7 == stats.hits + stats.coalesced);
+    }
+
+    SECTION("lets waiters retry when the call they wait for throws")
+    {
+        std::atomic<int> calls{0};
+        auto flaky = memoize<int>(
+            [&calls](int x) {
+                auto call = ++calls;
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                if (call == 1) {
+                    throw std::runtime_error("first call fails");
+                }
+                return result<int, int>::ok(x + 1);
+            },
+            16);
+
+        std::atomic<int> thrown{0};
+        std::atomic<int> sum{0};
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 8; ++i) {
+            threads.emplace_back([&]() {
+                try {
+                    sum += flaky(1).ok_value();
+                } catch (const std::runtime_error&) {
+                    ++thrown;
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        REQUIRE(1 == thrown.load());
+        REQUIRE(2 == calls.load());
+        REQUIRE(14 == sum.load());
+        REQUIRE(2 == flaky(1).ok_value());
+    }
+}
@@ -0,0 +1,60 @@
+// Built with -fno-exceptions once per bad access policy, see CMakeLists.txt. Returns 0 if the
+// combinators work and bad access reaches the selected policy. Catch needs exceptions, so this
+// checks by hand.
+
+#include <maybe/result.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using maybe::result;
+
+#if MAYBE_RESULT_BAD_ACCESS == MAYBE_RESULT_BAD_ACCESS_HANDLER
+[[noreturn]] void maybe::bad_access_handler(const char* message)
+{
+    std::exit(std::strcmp(message, "ok_value() without ok value") == 0 ? 0 : 1);
+}
+#endif
+
+namespace {
+    int failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition) {
+            std::fprintf(stderr, "failed: %s\n", what);
+            ++failures;
+        }
+    }
+
+    result<int, std::string> parse(int x)
+    {
+        return x < 0 ? result<int, std::string>::err("negative") : result<int, std::string>::ok(x);
+    }
+}
+
+int main()
+{
+    auto ok = parse(2).map([](int x) { return x * 2; }).and_then(parse);
+    auto err = parse(-1).map([](int x) { return x * 2; }).map_err([](std::string e) {
+        return e.size();
+    });
+    auto void_err = result<void, int>::err(3);
+
+    check(ok.is_ok() && ok.ok_value() == 4, "ok chain");
+    check(err.is_err() && err.err_value() == 8, "err chain");
+    check(void_err.err_value() == 3, "void err");
+
+    if (failures != 0) {
+        return 1;
+    }
+
+#if MAYBE_RESULT_BAD_ACCESS != MAYBE_RESULT_BAD_ACCESS_ASSUME
+    // Does not return: the handler exits with 0, abort is expected by expect_abort.cmake.
+    return err.ok_value() == 0 ? 1 : 2;
+#else
+    return 0;
+#endif
+}
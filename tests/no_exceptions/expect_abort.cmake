@@ -0,0 +1,20 @@
+#
+# Copyright 2016 TRAFI
+#
+# Licensed under the Apache License, Version 2.0, <LICENSE-APACHE or
+# http://apache.org/licenses/LICENSE-2.0> or the MIT license <LICENSE-MIT or
+# http://opensource.org/licenses/MIT>, at your option. This file may not be
+# copied, modified, or distributed except according to those terms.
+#
+
+# Runs PROGRAM and succeeds if it aborts after printing the bad access message. Run with
+# cmake -P, since CTest counts a signal as failure even for WILL_FAIL tests.
+
+execute_process(COMMAND ${PROGRAM} RESULT_VARIABLE status ERROR_VARIABLE errors)
+if(status EQUAL 0 OR status EQUAL 1 OR status EQUAL 2)
+    message(FATAL_ERROR "${PROGRAM} did not abort, exit code ${status}:\n${errors}")
+endif()
+if(NOT errors MATCHES "maybe::result: ok_value\\(\\) without ok value")
+    message(FATAL_ERROR "${PROGRAM} aborted without the bad access message:\n${errors}")
+endif()
+message(STATUS "${PROGRAM}: ${status}")
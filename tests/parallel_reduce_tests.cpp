@@ -0,0 +1,123 @@
+#include "catch.hpp"
+
+#include <maybe/executor.hpp>
+#include <maybe/parallel.hpp>
+#include <numeric>
+#include <string>
+#include <vector>
+
+using maybe::result;
+
+TEST_CASE("parallel_reduce")
+{
+    maybe::parallel::options small_grain;
+    small_grain.threads = 4;
+    small_grain.grain = 16;
+
+    auto add = [](long a, long b) { return result<long, std::string>::ok(a + b); };
+
+    SECTION("sums all elements when every combine step is ok")
+    {
+        std::vector<long> values(10000);
+        std::iota(values.begin(), values.end(), 1);
+
+        auto sum = maybe::parallel::reduce(values, 5l, add, small_grain);
+        REQUIRE(sum);
+        REQUIRE(50005005 == sum.ok_value());
+    }
+
+    SECTION("returns init for an empty range")
+    {
+        std::vector<long> values;
+
+        auto sum = maybe::parallel::reduce(values, 7l, add, small_grain);
+        REQUIRE(sum);
+        REQUIRE(7 == sum.ok_value());
+    }
+
+    SECTION("preserves element order for associative but not commutative combine")
+    {
+        std::vector<std::string> values;
+        for (int i = 0; i < 1000; ++i) {
+            values.push_back(std::to_string(i % 10));
+        }
+
+        auto joined = maybe::parallel::reduce(
+            values,
+            std::string(">"),
+            [](std::string a, std::string b) { return result<std::string, int>::ok(a + b); },
+            small_grain);
+
+        auto expected = std::accumulate(values.begin(), values.end(), std::string(">"));
+        REQUIRE(joined);
+        REQUIRE(expected == joined.ok_value());
+    }
+
+    SECTION("returns the error of the lowest failing element")
+    {
+        std::vector<long> values(10000, 1);
+        values[9000] = -9000;
+        values[4000] = -4000;
+        values[7000] = -7000;
+
+        auto sum = maybe::parallel::reduce(values,
+                                           0l,
+                                           [](long a, long b) {
+                                               if (b < 0) {
+                                                   return result<long, long>::err(b);
+                                               }
+                                               return result<long, long>::ok(a + b);
+                                           },
+                                           small_grain);
+        REQUIRE(!sum);
+        REQUIRE(-4000 == sum.err_value());
+    }
+
+    SECTION("reduces on the calling thread when the range is shorter than two grains")
+    {
+        std::vector<long> values(10, 2);
+
+        auto sum = maybe::parallel::reduce(values, 0l, add);
+        REQUIRE(sum);
+        REQUIRE(20 == sum.ok_value());
+    }
+
+    SECTION("reduces on an executor")
+    {
+        maybe::executor executor(2);
+        std::vector<long> values(10000);
+        std::iota(values.begin(), values.end(), 1);
+
+        auto sum = maybe::parallel::reduce(executor, values, 5l, add, small_grain);
+        REQUIRE(sum);
+        REQUIRE(50005005 == sum.ok_value());
+
+        values[6000] = -1;
+        auto failed = maybe::parallel::reduce(executor,
+                                              values,
+                                              0l,
+                                              [](long a, long b) {
+                                                  if (b < 0) {
+                                                      return result<long, long>::err(b);
+                                                  }
+                                                  return result<long, long>::ok(a + b);
+                                              },
+                                              small_grain);
+        REQUIRE(!failed);
+        REQUIRE(-1 == failed.err_value());
+    }
+
+    SECTION("runs a reduction nested in a task on the same executor")
+    {
+        maybe::executor executor(1);
+        std::vector<long> values(10000, 1);
+
+        auto sum = executor
+                       .submit([&]() {
+                           return maybe::parallel::reduce(executor, values, 0l, add, small_grain);
+                       })
+                       .get();
+        REQUIRE(sum);
+        REQUIRE(10000 == sum.ok_value());
+    }
+}
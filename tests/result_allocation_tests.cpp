@@ -0,0 +1,205 @@
+#include "catch.hpp"
+
+#include "allocation_counter.hpp"
+
+#include <maybe/ranges.hpp>
+#include <maybe/result.hpp>
+#include <string>
+#include <vector>
+
+using maybe::result;
+
+// Combinators called on rvalues move payloads between results and into the user's functions, so
+// a chain allocates exactly what its functions allocate. On lvalues they pass the payload to the
+// function as an lvalue, so a by-value function copies it, and copy a payload they pass through,
+// so the receiver keeps it either way. Payloads are created before counting starts, and strings
+// are long enough to never fit the small string optimization.
+
+namespace {
+    typedef result<std::vector<int>, std::string> vector_result;
+    typedef result<std::string, std::string> string_result;
+
+    std::string heap_string(char c)
+    {
+        return std::string(64, c);
+    }
+
+    vector_result ok_vector()
+    {
+        return vector_result::ok(std::vector<int>(100, 1));
+    }
+
+    vector_result err_vector()
+    {
+        return vector_result::err(heap_string('e'));
+    }
+}
+
+TEST_CASE("result_allocations")
+{
+    SECTION("map copies the ok value of an lvalue and moves the ok value of an rvalue")
+    {
+        auto lvalue = ok_vector();
+        auto rvalue = ok_vector();
+
+        allocation_counter counter;
+        auto a = lvalue.map([](std::vector<int> v) {
+            v[0] = 2;
+            return v;
+        });
+        auto copy_allocations = counter.allocations();
+        auto b = std::move(rvalue).map([](std::vector<int> v) { return v.size(); });
+        auto allocations = counter.allocations();
+
+        REQUIRE(1 == copy_allocations);
+        REQUIRE(1 == allocations);
+        REQUIRE(2 == a.ok_value()[0]);
+        REQUIRE(1 == lvalue.ok_value()[0]);
+        REQUIRE(100 == lvalue.ok_value().size());
+        REQUIRE(100 == b.ok_value());
+    }
+
+    SECTION("map copies the err value of an lvalue and moves the err value of an rvalue")
+    {
+        auto lvalue = err_vector();
+        auto rvalue = err_vector();
+
+        allocation_counter counter;
+        auto a = lvalue.map([](std::vector<int> v) { return v.size(); });
+        auto copy_allocations = counter.allocations();
+        auto b = std::move(rvalue).map([](std::vector<int> v) { return v.size(); });
+        auto allocations = counter.allocations();
+
+        REQUIRE(1 == copy_allocations);
+        REQUIRE(1 == allocations);
+        REQUIRE(heap_string('e') == a.err_value());
+        REQUIRE(heap_string('e') == lvalue.err_value());
+        REQUIRE(heap_string('e') == b.err_value());
+    }
+
+    SECTION("map_err copies the values of an lvalue and moves the values of an rvalue")
+    {
+        auto err = string_result::err(heap_string('e'));
+        auto ok = string_result::ok(heap_string('k'));
+        auto rvalue_err = string_result::err(heap_string('r'));
+        auto rvalue_ok = string_result::ok(heap_string('o'));
+
+        allocation_counter counter;
+        auto a = err.map_err([](std::string e) {
+            e[0] = 'x';
+            return e;
+        });
+        auto d = ok.map_err([](std::string e) { return e.size(); });
+        auto copy_allocations = counter.allocations();
+        auto b = std::move(rvalue_ok).map_err([](std::string e) { return e.size(); });
+        auto c = std::move(rvalue_err).map_err([](std::string e) { return e; });
+        auto allocations = counter.allocations();
+
+        REQUIRE(2 == copy_allocations);
+        REQUIRE(2 == allocations);
+        REQUIRE('x' == a.err_value()[0]);
+        REQUIRE(heap_string('e') == err.err_value());
+        REQUIRE(heap_string('k') == d.ok_value());
+        REQUIRE(heap_string('k') == ok.ok_value());
+        REQUIRE(heap_string('o') == b.ok_value());
+        REQUIRE(heap_string('r') == c.err_value());
+    }
+
+    SECTION("and_then on an rvalue allocates only what f allocates")
+    {
+        auto lvalue = ok_vector();
+        auto lvalue_err = err_vector();
+        auto rvalue = ok_vector();
+        auto err = err_vector();
+
+        allocation_counter counter;
+        auto a = lvalue.and_then(
+            [](std::vector<int> v) { return string_result::ok(std::string(v.size(), 'a')); });
+        auto d = lvalue_err.and_then(
+            [](std::vector<int> v) { return string_result::ok(std::string(v.size(), 'd')); });
+        auto copy_allocations = counter.allocations();
+        auto b = std::move(rvalue).and_then(
+            [](std::vector<int> v) { return string_result::ok(std::string(v.size(), 'b')); });
+        auto c = std::move(err).and_then(
+            [](std::vector<int> v) { return string_result::ok(std::string(v.size(), 'c')); });
+        auto allocations = counter.allocations();
+
+        // The lvalue's vector is copied, then f allocates its string. The other lvalue's err
+        // value is copied.
+        REQUIRE(3 == copy_allocations);
+        REQUIRE(4 == allocations);
+        REQUIRE(100 == a.ok_value().size());
+        REQUIRE(100 == lvalue.ok_value().size());
+        REQUIRE(heap_string('e') == d.err_value());
+        REQUIRE(heap_string('e') == lvalue_err.err_value());
+        REQUIRE(100 == b.ok_value().size());
+        REQUIRE(heap_string('e') == c.err_value());
+    }
+
+    SECTION("into_err moves the err value")
+    {
+        auto lvalue = err_vector();
+        auto rvalue = string_result::err(heap_string('r'));
+
+        allocation_counter counter;
+        auto a = lvalue.into_err<std::string>();
+        auto b = std::move(rvalue).into_err<std::vector<int>>();
+        auto allocations = counter.allocations();
+
+        REQUIRE(0 == allocations);
+        REQUIRE(heap_string('e') == a.err_value());
+        REQUIRE(heap_string('r') == b.err_value());
+    }
+
+    SECTION("a chain allocates exactly what its functions allocate")
+    {
+        auto input = ok_vector();
+
+        allocation_counter counter;
+        auto out = std::move(input)
+                       .and_then([](std::vector<int> v) {
+                           v.push_back(2);
+                           return vector_result::ok(std::move(v));
+                       })
+                       .map([](std::vector<int> v) { return heap_string(char('0' + v.back())); })
+                       .map_err([](std::string e) { return e.size(); })
+                       .map([](std::string s) { return s.size(); });
+        auto allocations = counter.allocations();
+        auto deallocations = counter.deallocations();
+
+        // push_back grows the vector and heap_string allocates, the rest only moves. The vector
+        // is freed twice, before and after growing, and the string once.
+        REQUIRE(2 == allocations);
+        REQUIRE(3 == deallocations);
+        REQUIRE(64 == out.ok_value());
+    }
+
+    SECTION("views over results allocate no intermediate containers")
+    {
+        std::vector<string_result> values;
+        for (int i = 0; i < 10; ++i) {
+            values.push_back(i % 3 == 0 ? string_result::err(heap_string('e'))
+                                        : string_result::ok(heap_string('o')));
+        }
+
+        allocation_counter counter;
+        std::size_t ok_size = 0;
+        for (auto size : values | maybe::transform_ok([](const std::string& s) { return s.size(); })
+                 | maybe::filter_ok()) {
+            ok_size += size;
+        }
+        auto transform_allocations = counter.allocations();
+        std::size_t err_count = 0;
+        for (auto& e : values | maybe::errors()) {
+            err_count += e.size() == 64;
+        }
+        auto allocations = counter.allocations();
+
+        // transform_ok yields results that own their err values, so each err of a range it does
+        // not own is copied once. errors and filter_ok yield references.
+        REQUIRE(4 == transform_allocations);
+        REQUIRE(4 == allocations);
+        REQUIRE(6 * 64 == ok_size);
+        REQUIRE(4 == err_count);
+    }
+}
@@ -33,7 +33,7 @@ TEST_CASE("result_and_then")
     SECTION("chains another function returning different void result if previous one was successful")
     {
         auto a = result<A, int>::ok(A("hello"));
-        auto b = a.and_then([](A v) { return result<void, int>::ok(); });
+        auto b = a.and_then([](A) { return result<void, int>::ok(); });
         REQUIRE(b);
     }
 
@@ -58,7 +58,7 @@ TEST_CASE("result_and_then")
             "should not run another function returning different void result if previous one returned error")
     {
         auto a = result<A, int>::err(43);
-        auto b = a.and_then([](A v) { return result<void, int>::ok(); });
+        auto b = a.and_then([](A) { return result<void, int>::ok(); });
         REQUIRE(!b);
         REQUIRE(43 == b.err_value());
     }
@@ -0,0 +1,112 @@
+#include "catch.hpp"
+
+#include <maybe/result.hpp>
+#include <maybe/transpose.hpp>
+#include <memory>
+#include <string>
+
+using maybe::result;
+using std::experimental::optional;
+
+TEST_CASE("result_flatten")
+{
+    SECTION("returns the inner ok result")
+    {
+        auto a = result<result<std::string, int>, int>::ok(result<std::string, int>::ok("hi"));
+        auto b = std::move(a).flatten();
+        REQUIRE(b);
+        REQUIRE("hi" == b.ok_value());
+    }
+
+    SECTION("returns the inner err result")
+    {
+        auto a = result<result<std::string, int>, int>::ok(result<std::string, int>::err(42));
+        auto b = std::move(a).flatten();
+        REQUIRE(!b);
+        REQUIRE(42 == b.err_value());
+    }
+
+    SECTION("forwards the outer err value")
+    {
+        auto a = result<result<std::string, int>, int>::err(43);
+        auto b = std::move(a).flatten();
+        REQUIRE(!b);
+        REQUIRE(43 == b.err_value());
+    }
+
+    SECTION("flattens results of map with a fallible callback")
+    {
+        auto b = result<int, int>::ok(2)
+                     .map([](int v) {
+                         return v > 1 ? result<std::unique_ptr<int>, int>::ok(
+                                            std::unique_ptr<int>(new int(v)))
+                                      : result<std::unique_ptr<int>, int>::err(v);
+                     })
+                     .flatten();
+        REQUIRE(b);
+        REQUIRE(2 == *b.ok_value());
+    }
+
+    SECTION("flattens nested void results")
+    {
+        auto a = result<result<void, int>, int>::ok(result<void, int>::ok());
+        auto b = std::move(a).flatten();
+        REQUIRE(b);
+    }
+}
+
+TEST_CASE("result_transpose")
+{
+    SECTION("converts an empty optional into an ok empty optional")
+    {
+        optional<result<int, std::string>> a;
+        auto b = maybe::transpose(a);
+        REQUIRE(b);
+        REQUIRE(!b.ok_value());
+    }
+
+    SECTION("converts an optional ok result into an ok optional")
+    {
+        auto b = maybe::transpose(optional<result<int, std::string>>(result<int, std::string>::ok(1)));
+        REQUIRE(b);
+        REQUIRE(1 == *b.ok_value());
+    }
+
+    SECTION("converts an optional err result into an err result")
+    {
+        auto b = maybe::transpose(
+            optional<result<int, std::string>>(result<int, std::string>::err("miss")));
+        REQUIRE(!b);
+        REQUIRE("miss" == b.err_value());
+    }
+
+    SECTION("converts an ok empty optional into an empty optional")
+    {
+        auto b = maybe::transpose(result<optional<int>, std::string>::ok(optional<int>()));
+        REQUIRE(!b);
+    }
+
+    SECTION("converts an ok optional into an optional ok result")
+    {
+        auto a = result<optional<std::string>, int>::ok(optional<std::string>("hi"));
+        auto b = maybe::transpose(a);
+        REQUIRE(b);
+        REQUIRE("hi" == b->ok_value());
+        REQUIRE("hi" == *a.ok_value());
+    }
+
+    SECTION("converts an err result into an optional err result")
+    {
+        auto b = maybe::transpose(result<optional<int>, std::string>::err("failed"));
+        REQUIRE(b);
+        REQUIRE("failed" == b->err_value());
+    }
+
+    SECTION("round trips through both directions")
+    {
+        auto a = optional<result<int, std::string>>(result<int, std::string>::ok(7));
+        auto b = maybe::transpose(maybe::transpose(a));
+        REQUIRE(b);
+        REQUIRE(*b == *a);
+    }
+}
@@ -0,0 +1,163 @@
+#include "catch.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <maybe/result.hpp>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using maybe::result;
+
+// Layout of result<T, E> and result<void, E> for a matrix of payloads. A result is its
+// optional storage and nothing more: these assertions fail if a change to result.hpp adds a
+// member, loses a payload's trivial destructor or makes moves throwing.
+
+namespace {
+    enum class small_enum : unsigned char { a, b };
+    enum plain_enum { first, second };
+
+    struct empty {
+    };
+
+    struct alignas(32) over_aligned {
+        char c;
+    };
+
+    struct move_only {
+        std::unique_ptr<int> p;
+    };
+
+    template <typename T>
+    using optional = std::experimental::optional<T>;
+
+    constexpr std::size_t align_up(std::size_t n, std::size_t alignment)
+    {
+        return (n + alignment - 1) / alignment * alignment;
+    }
+
+    constexpr std::size_t max_size(std::size_t a, std::size_t b)
+    {
+        return a < b ? b : a;
+    }
+
+    template <typename T, typename E>
+    struct expected_layout final {
+        static constexpr std::size_t align = max_size(alignof(optional<T>), alignof(optional<E>));
+        static constexpr std::size_t size = align_up(
+            align_up(sizeof(optional<T>), alignof(optional<E>)) + sizeof(optional<E>), align);
+    };
+
+    template <typename T, typename E>
+    constexpr bool check_layout()
+    {
+        typedef result<T, E> r;
+
+        static_assert(sizeof(r) == expected_layout<T, E>::size,
+                      "result<T, E> is larger than its two optionals");
+        static_assert(alignof(r) == expected_layout<T, E>::align,
+                      "result<T, E> is aligned differently than its optionals");
+        static_assert(std::is_trivially_copyable<r>::value
+                          == (std::is_trivially_copyable<optional<T>>::value
+                              && std::is_trivially_copyable<optional<E>>::value),
+                      "result<T, E> changes trivial copyability of its optionals");
+        static_assert(std::is_trivially_destructible<r>::value
+                          == (std::is_trivially_destructible<T>::value
+                              && std::is_trivially_destructible<E>::value),
+                      "result<T, E> changes trivial destructibility of its payloads");
+        static_assert(std::is_nothrow_move_constructible<r>::value,
+                      "result<T, E> move construction may throw");
+        static_assert(std::is_nothrow_move_assignable<r>::value,
+                      "result<T, E> move assignment may throw");
+        return true;
+    }
+
+    template <typename E>
+    constexpr bool check_void_layout()
+    {
+        typedef result<void, E> r;
+
+        static_assert(sizeof(r) == sizeof(optional<E>),
+                      "result<void, E> is larger than its optional");
+        static_assert(alignof(r) == alignof(optional<E>),
+                      "result<void, E> is aligned differently than its optional");
+        static_assert(std::is_trivially_copyable<r>::value
+                          == std::is_trivially_copyable<optional<E>>::value,
+                      "result<void, E> changes trivial copyability of its optional");
+        static_assert(std::is_trivially_destructible<r>::value
+                          == std::is_trivially_destructible<E>::value,
+                      "result<void, E> changes trivial destructibility of its payload");
+        static_assert(std::is_nothrow_move_constructible<r>::value,
+                      "result<void, E> move construction may throw");
+        static_assert(std::is_nothrow_move_assignable<r>::value,
+                      "result<void, E> move assignment may throw");
+        return true;
+    }
+
+    static_assert(check_layout<char, char>(), "");
+    static_assert(check_layout<int, int>(), "");
+    static_assert(check_layout<int*, int>(), "");
+    static_assert(check_layout<const char*, std::string>(), "");
+    static_assert(check_layout<small_enum, int>(), "");
+    static_assert(check_layout<plain_enum, small_enum>(), "");
+    static_assert(check_layout<std::string, int>(), "");
+    static_assert(check_layout<int, std::string>(), "");
+    static_assert(check_layout<std::string, std::string>(), "");
+    static_assert(check_layout<std::vector<int>, int>(), "");
+    static_assert(check_layout<std::vector<std::string>, std::string>(), "");
+    static_assert(check_layout<over_aligned, int>(), "");
+    static_assert(check_layout<int, over_aligned>(), "");
+    static_assert(check_layout<empty, int>(), "");
+    static_assert(check_layout<empty, empty>(), "");
+    static_assert(check_layout<move_only, int>(), "");
+    static_assert(check_layout<std::unique_ptr<int>, std::string>(), "");
+
+    static_assert(check_void_layout<char>(), "");
+    static_assert(check_void_layout<int>(), "");
+    static_assert(check_void_layout<small_enum>(), "");
+    static_assert(check_void_layout<std::string>(), "");
+    static_assert(check_void_layout<std::vector<int>>(), "");
+    static_assert(check_void_layout<over_aligned>(), "");
+    static_assert(check_void_layout<empty>(), "");
+    static_assert(check_void_layout<move_only>(), "");
+
+    // Sizes for payloads whose layout does not depend on the standard library. An optional adds
+    // one flag byte, padded to the payload's alignment.
+    static_assert(sizeof(result<char, char>) == 4, "");
+    static_assert(sizeof(result<int, int>) == 4 * sizeof(int), "");
+    static_assert(sizeof(result<small_enum, small_enum>) == 4, "");
+    static_assert(sizeof(result<empty, empty>) == 4, "");
+    static_assert(sizeof(result<int*, int*>) == 4 * sizeof(int*), "");
+    static_assert(sizeof(result<over_aligned, over_aligned>) == 4 * alignof(over_aligned), "");
+    static_assert(sizeof(result<void, int>) == 2 * sizeof(int), "");
+    static_assert(sizeof(result<void, char>) == 2, "");
+    static_assert(alignof(result<over_aligned, int>) == alignof(over_aligned), "");
+}
+
+TEST_CASE("result layout")
+{
+    SECTION("over-aligned payloads are aligned in place")
+    {
+        auto ok = result<over_aligned, int>::ok(over_aligned{'x'});
+        auto err = result<int, over_aligned>::err(over_aligned{'y'});
+        auto void_err = result<void, over_aligned>::err(over_aligned{'z'});
+
+        REQUIRE(reinterpret_cast<std::uintptr_t>(&ok.ok_value()) % alignof(over_aligned) == 0);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(&err.err_value()) % alignof(over_aligned) == 0);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(&void_err.err_value()) % alignof(over_aligned)
+                == 0);
+        REQUIRE(ok.ok_value().c == 'x');
+        REQUIRE(err.err_value().c == 'y');
+        REQUIRE(void_err.err_value().c == 'z');
+    }
+
+    SECTION("move-only payloads move without copying")
+    {
+        auto r = result<move_only, int>::ok(move_only{std::unique_ptr<int>(new int(42))});
+        auto moved = std::move(r);
+
+        REQUIRE(moved.is_ok());
+        REQUIRE(*moved.ok_value().p == 42);
+    }
+}
@@ -0,0 +1,119 @@
+#include "catch.hpp"
+
+#include <maybe/ranges.hpp>
+#include <string>
+#include <vector>
+
+using maybe::result;
+
+namespace {
+    std::vector<result<int, std::string>> mixed()
+    {
+        return {
+            result<int, std::string>::ok(1),
+            result<int, std::string>::err("two"),
+            result<int, std::string>::ok(3),
+            result<int, std::string>::err("four"),
+            result<int, std::string>::ok(5),
+        };
+    }
+}
+
+TEST_CASE("result_ranges")
+{
+    SECTION("transform_ok maps ok values and passes errors through")
+    {
+        auto values = mixed();
+
+        std::vector<result<std::string, std::string>> mapped;
+        for (auto r : values | maybe::transform_ok([](int v) { return std::to_string(v * 10); })) {
+            mapped.push_back(r);
+        }
+
+        REQUIRE(5 == mapped.size());
+        REQUIRE("10" == mapped[0].ok_value());
+        REQUIRE("two" == mapped[1].err_value());
+        REQUIRE("50" == mapped[4].ok_value());
+        REQUIRE("two" == values[1].err_value());
+    }
+
+    SECTION("and_then_each chains fallible functions on ok values")
+    {
+        auto values = mixed();
+
+        std::vector<result<int, std::string>> chained;
+        for (auto r : maybe::and_then_each(values, [](int v) {
+                 return v > 1 ? result<int, std::string>::ok(v)
+                              : result<int, std::string>::err("too small");
+             })) {
+            chained.push_back(r);
+        }
+
+        REQUIRE(5 == chained.size());
+        REQUIRE("too small" == chained[0].err_value());
+        REQUIRE("two" == chained[1].err_value());
+        REQUIRE(3 == chained[2].ok_value());
+    }
+
+    SECTION("filter_ok yields only ok values")
+    {
+        std::vector<int> oks;
+        for (auto v : mixed() | maybe::filter_ok()) {
+            oks.push_back(v);
+        }
+
+        REQUIRE((std::vector<int>{1, 3, 5}) == oks);
+    }
+
+    SECTION("errors yields only err values")
+    {
+        auto values = mixed();
+
+        std::vector<std::string> errs;
+        for (auto& e : maybe::errors(values)) {
+            errs.push_back(e);
+        }
+
+        REQUIRE((std::vector<std::string>{"two", "four"}) == errs);
+    }
+
+    SECTION("take_while_ok stops before the first error without reading further")
+    {
+        int calls = 0;
+        std::vector<int> oks;
+        for (auto v : mixed() | maybe::transform_ok([&calls](int v) {
+                          ++calls;
+                          return v;
+                      })
+                 | maybe::take_while_ok()) {
+            oks.push_back(v);
+        }
+
+        REQUIRE((std::vector<int>{1}) == oks);
+        REQUIRE(1 == calls);
+    }
+
+    SECTION("evaluates every stage once per element when stages are composed")
+    {
+        int calls = 0;
+        std::vector<int> oks;
+        for (auto v : mixed() | maybe::transform_ok([&calls](int v) {
+                          ++calls;
+                          return v + 1;
+                      })
+                 | maybe::filter_ok()) {
+            oks.push_back(v);
+        }
+
+        REQUIRE((std::vector<int>{2, 4, 6}) == oks);
+        REQUIRE(3 == calls);
+    }
+
+    SECTION("yields nothing for an empty range")
+    {
+        std::vector<result<int, std::string>> empty;
+
+        auto filtered = empty | maybe::filter_ok();
+        REQUIRE(filtered.begin() == filtered.end());
+    }
+}
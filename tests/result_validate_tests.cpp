@@ -0,0 +1,71 @@
+#include "catch.hpp"
+
+#include <maybe/validate.hpp>
+#include <string>
+
+using maybe::result;
+
+TEST_CASE("result_validate")
+{
+    auto name = result<std::string, std::string>::ok("Alice");
+    auto age = result<int, std::string>::ok(42);
+    auto bad_name = result<std::string, std::string>::err("name is empty");
+    auto bad_age = result<int, std::string>::err("age is negative");
+    auto bad_email = result<std::string, std::string>::err("email is invalid");
+
+    SECTION("combines ok values into a tuple")
+    {
+        auto v = maybe::validate(name, age);
+        REQUIRE(v);
+        REQUIRE("Alice" == std::get<0>(v.ok_value()));
+        REQUIRE(42 == std::get<1>(v.ok_value()));
+    }
+
+    SECTION("collects every error in positional order")
+    {
+        auto v = maybe::validate(bad_name, age, bad_age);
+        REQUIRE(!v);
+        REQUIRE(2 == v.err_value().size());
+        REQUIRE("name is empty" == v.err_value()[0]);
+        REQUIRE("age is negative" == v.err_value()[1]);
+        REQUIRE(!v.err_value().spilled());
+    }
+
+    SECTION("keeps errors past the inline capacity")
+    {
+        auto v = maybe::validate(bad_name, bad_age, bad_email);
+        REQUIRE(!v);
+        REQUIRE(v.err_value().spilled());
+
+        std::vector<std::string> errors(v.err_value().begin(), v.err_value().end());
+        REQUIRE((std::vector<std::string>{"name is empty", "age is negative", "email is invalid"})
+                == errors);
+    }
+
+    SECTION("does not consume lvalue arguments")
+    {
+        auto v = maybe::validate(bad_name, name);
+        REQUIRE(!v);
+        REQUIRE("name is empty" == bad_name.err_value());
+        REQUIRE("Alice" == name.ok_value());
+    }
+}
+
+TEST_CASE("error_list")
+{
+    SECTION("copies and moves inline and spilled errors")
+    {
+        maybe::error_list<std::string, 1> errors;
+        errors.push_back("first");
+        errors.emplace_back("second");
+
+        auto copy = errors;
+        auto moved = std::move(errors);
+
+        REQUIRE(copy == moved);
+        REQUIRE(2 == moved.size());
+        REQUIRE("first" == moved.front());
+        REQUIRE("second" == moved.back());
+        REQUIRE(errors.empty());
+    }
+}
@@ -0,0 +1,95 @@
+#include "catch.hpp"
+
+#include <maybe/zip.hpp>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+using maybe::result;
+
+TEST_CASE("result_zip")
+{
+    SECTION("combines ok values into a tuple")
+    {
+        auto z = maybe::zip(result<int, std::string>::ok(1),
+                            result<std::string, std::string>::ok("two"),
+                            result<double, std::string>::ok(3.0));
+        REQUIRE(z);
+        REQUIRE(1 == std::get<0>(z.ok_value()));
+        REQUIRE("two" == std::get<1>(z.ok_value()));
+        REQUIRE(3.0 == std::get<2>(z.ok_value()));
+    }
+
+    SECTION("returns the first error by position")
+    {
+        auto z = maybe::zip(result<int, std::string>::ok(1),
+                            result<int, std::string>::err("second"),
+                            result<int, std::string>::err("third"));
+        REQUIRE(!z);
+        REQUIRE("second" == z.err_value());
+    }
+
+    SECTION("copies payloads out of lvalue results")
+    {
+        auto a = result<std::string, int>::ok("a");
+        auto b = result<std::string, int>::ok("b");
+        auto z = maybe::zip(a, std::move(b));
+        REQUIRE(z);
+        REQUIRE("a" == a.ok_value());
+        REQUIRE("b" == std::get<1>(z.ok_value()));
+    }
+}
+
+TEST_CASE("result_zip_with")
+{
+    SECTION("applies the function to all ok values")
+    {
+        auto z = maybe::zip_with([](int a, std::string b) { return b + std::to_string(a); },
+                                 result<int, std::string>::ok(1),
+                                 result<std::string, std::string>::ok("two"));
+        REQUIRE(z);
+        REQUIRE("two1" == z.ok_value());
+    }
+
+    SECTION("does not call the function and returns the first error by position")
+    {
+        bool called = false;
+        auto z = maybe::zip_with(
+            [&called](int a, int b) {
+                called = true;
+                return a + b;
+            },
+            result<int, std::string>::err("first"),
+            result<int, std::string>::err("second"));
+        REQUIRE(!z);
+        REQUIRE("first" == z.err_value());
+        REQUIRE(!called);
+    }
+
+    SECTION("moves payloads out of rvalue results")
+    {
+        auto z = maybe::zip_with([](std::unique_ptr<int> a, int b) { return *a + b; },
+                                 result<std::unique_ptr<int>, std::string>::ok(
+                                     std::unique_ptr<int>(new int(40))),
+                                 result<int, std::string>::ok(2));
+        REQUIRE(z);
+        REQUIRE(42 == z.ok_value());
+    }
+
+    SECTION("returns a void result for a function returning void")
+    {
+        int sum = 0;
+        auto ok = maybe::zip_with([&sum](int a, int b) { sum = a + b; },
+                                  result<int, std::string>::ok(1),
+                                  result<int, std::string>::ok(2));
+        auto err = maybe::zip_with([&sum](int a, int b) { sum = a * b; },
+                                   result<int, std::string>::ok(3),
+                                   result<int, std::string>::err("second"));
+
+        static_assert(std::is_same<decltype(ok), result<void, std::string>>::value, "");
+        REQUIRE(ok);
+        REQUIRE(!err);
+        REQUIRE("second" == err.err_value());
+        REQUIRE(3 == sum);
+    }
+}
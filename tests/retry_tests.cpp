@@ -0,0 +1,127 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <maybe/executor.hpp>
+#include <maybe/retry.hpp>
+#include <string>
+
+using maybe::async_result;
+using maybe::result;
+using maybe::retry_policy;
+
+namespace {
+    enum class CallError {
+        Unavailable,
+        BadRequest,
+    };
+
+    retry_policy<CallError> fast_policy()
+    {
+        retry_policy<CallError> policy;
+        policy.max_attempts = 4;
+        policy.initial_delay = std::chrono::milliseconds(1);
+        policy.should_retry = [](const CallError& e) { return e == CallError::Unavailable; };
+        return policy;
+    }
+}
+
+TEST_CASE("retry")
+{
+    SECTION("computes exponential delays with a cap")
+    {
+        retry_policy<CallError> policy;
+        policy.initial_delay = std::chrono::milliseconds(10);
+        policy.max_delay = std::chrono::milliseconds(50);
+        policy.jitter = 0;
+
+        REQUIRE(std::chrono::milliseconds(10) == policy.delay(1));
+        REQUIRE(std::chrono::milliseconds(20) == policy.delay(2));
+        REQUIRE(std::chrono::milliseconds(40) == policy.delay(3));
+        REQUIRE(std::chrono::milliseconds(50) == policy.delay(4));
+        REQUIRE(std::chrono::milliseconds(50) == policy.delay(40));
+    }
+
+    SECTION("subtracts at most the jitter fraction")
+    {
+        retry_policy<CallError> policy;
+        policy.initial_delay = std::chrono::milliseconds(100);
+        policy.jitter = 0.25;
+
+        for (int i = 0; i < 100; ++i) {
+            auto d = policy.delay(1);
+            REQUIRE(d <= std::chrono::milliseconds(100));
+            REQUIRE(d >= std::chrono::milliseconds(75));
+        }
+    }
+
+    SECTION("retries transient errors until ok")
+    {
+        int calls = 0;
+        auto r = maybe::retry(fast_policy(), [&calls]() {
+            return ++calls < 3 ? result<int, CallError>::err(CallError::Unavailable)
+                               : result<int, CallError>::ok(calls);
+        });
+        REQUIRE(r);
+        REQUIRE(3 == r.ok_value());
+    }
+
+    SECTION("stops at errors rejected by the policy")
+    {
+        int calls = 0;
+        auto r = maybe::retry(fast_policy(), [&calls]() {
+            ++calls;
+            return result<void, CallError>::err(CallError::BadRequest);
+        });
+        REQUIRE(!r);
+        REQUIRE(CallError::BadRequest == r.err_value());
+        REQUIRE(1 == calls);
+    }
+
+    SECTION("returns the last error once attempts run out")
+    {
+        int calls = 0;
+        auto r = maybe::retry(fast_policy(), [&calls]() {
+            ++calls;
+            return result<int, CallError>::err(CallError::Unavailable);
+        });
+        REQUIRE(!r);
+        REQUIRE(4 == calls);
+    }
+
+    SECTION("retries asynchronously on the executor")
+    {
+        maybe::executor executor(1);
+        std::atomic<int> calls{0};
+
+        auto r = maybe::retry_async(executor,
+                                    fast_policy(),
+                                    [&calls]() {
+                                        return ++calls < 3
+                                            ? result<int, CallError>::err(CallError::Unavailable)
+                                            : result<int, CallError>::ok(calls.load());
+                                    })
+                     .get();
+        REQUIRE(r);
+        REQUIRE(3 == r.ok_value());
+    }
+
+    SECTION("retries functions returning async results")
+    {
+        maybe::executor executor(2);
+        std::atomic<int> calls{0};
+
+        auto r = maybe::retry_async(executor,
+                                    fast_policy(),
+                                    [&executor, &calls]() {
+                                        return executor.submit([&calls]() {
+                                            ++calls;
+                                            return result<std::string, CallError>::err(
+                                                CallError::Unavailable);
+                                        });
+                                    })
+                     .get();
+        REQUIRE(!r);
+        REQUIRE(CallError::Unavailable == r.err_value());
+        REQUIRE(4 == calls.load());
+    }
+}
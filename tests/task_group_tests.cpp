@@ -0,0 +1,162 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <maybe/task_group.hpp>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using maybe::result;
+using maybe::task_group;
+
+namespace {
+    void spawn_tree(task_group<std::string>& group, std::atomic<int>& done, int depth)
+    {
+        ++done;
+        if (depth == 0) {
+            return;
+        }
+        for (int i = 0; i < 2; ++i) {
+            group.spawn([&group, &done, depth]() {
+                spawn_tree(group, done, depth - 1);
+                return result<void, std::string>::ok();
+            });
+        }
+    }
+}
+
+TEST_CASE("task_group")
+{
+    SECTION("waits for all tasks and stores their ok values")
+    {
+        maybe::executor executor(2);
+        std::vector<int> out(100, 0);
+        {
+            task_group<std::string> group(executor);
+            for (int i = 0; i < 100; ++i) {
+                group.spawn(out[i], [i]() { return result<int, std::string>::ok(i * 2); });
+            }
+            REQUIRE(group.wait());
+        }
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(i * 2 == out[i]);
+        }
+    }
+
+    SECTION("returns the first error and skips queued tasks")
+    {
+        maybe::executor executor(1);
+        std::atomic<int> ran{0};
+        std::atomic<bool> release{false};
+
+        task_group<std::string> group(executor);
+        group.spawn([&]() {
+            while (!release.load()) {
+                std::this_thread::yield();
+            }
+            return result<void, std::string>::err("first");
+        });
+        for (int i = 0; i < 10; ++i) {
+            group.spawn([&ran]() {
+                ++ran;
+                return result<void, std::string>::err("later");
+            });
+        }
+        release = true;
+
+        auto r = group.wait();
+        REQUIRE(!r);
+        REQUIRE("first" == r.err_value());
+        REQUIRE(0 == ran.load());
+        REQUIRE(group.token().is_cancelled());
+    }
+
+    SECTION("lets running tasks observe cancellation")
+    {
+        maybe::executor executor(2);
+        std::atomic<bool> stopped{false};
+
+        task_group<std::string> group(executor);
+        group.spawn([&group, &stopped]() {
+            while (!group.token().is_cancelled()) {
+                std::this_thread::yield();
+            }
+            stopped = true;
+            return result<void, std::string>::ok();
+        });
+        group.spawn([]() { return result<void, std::string>::err("stop"); });
+
+        REQUIRE("stop" == group.wait().err_value());
+        REQUIRE(stopped.load());
+    }
+
+    SECTION("waits for tasks spawned by tasks, also from a worker thread")
+    {
+        maybe::executor executor(1);
+        std::atomic<int> done{0};
+        std::atomic<bool> finished{false};
+
+        executor.execute([&]() {
+            task_group<std::string> group(executor, 256);
+            spawn_tree(group, done, 9);
+            group.wait();
+            finished = true;
+        });
+        while (!finished.load()) {
+            std::this_thread::yield();
+        }
+
+        REQUIRE(1023 == done.load());
+    }
+
+    SECTION("does not let tasks outlive the scope")
+    {
+        maybe::executor executor(2);
+        std::atomic<int> done{0};
+        {
+            task_group<int> group(executor);
+            for (int i = 0; i < 50; ++i) {
+                group.spawn([&done]() {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    ++done;
+                    return result<void, int>::ok();
+                });
+            }
+        }
+        REQUIRE(50 == done.load());
+    }
+
+    SECTION("fails the group with the exception of a throwing task")
+    {
+        maybe::executor executor(2);
+        std::atomic<int> done{0};
+
+        task_group<std::string> group(executor);
+        for (int i = 0; i < 20; ++i) {
+            group.spawn([&done]() {
+                ++done;
+                return result<void, std::string>::ok();
+            });
+        }
+        group.spawn([]() -> result<void, std::string> { throw std::runtime_error("thrown"); });
+
+        REQUIRE_THROWS_AS(group.wait(), const std::runtime_error&);
+        REQUIRE(group.token().is_cancelled());
+        REQUIRE_THROWS_AS(group.wait(), const std::runtime_error&);
+    }
+
+    SECTION("does not hang in the destructor when a task throws")
+    {
+        maybe::executor executor(2);
+        std::atomic<bool> ran{false};
+        {
+            task_group<int> group(executor);
+            group.spawn([&ran]() -> result<void, int> {
+                ran = true;
+                throw std::runtime_error("thrown");
+            });
+        }
+        REQUIRE(ran.load());
+    }
+}
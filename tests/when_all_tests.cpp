@@ -0,0 +1,117 @@
+#include "catch.hpp"
+
+#include <maybe/executor.hpp>
+#include <maybe/when_all.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+using maybe::async_promise;
+using maybe::async_result;
+using maybe::result;
+
+TEST_CASE("when_all")
+{
+    SECTION("combines ok values of all results")
+    {
+        async_promise<int, std::string> a;
+        async_promise<std::string, std::string> b;
+
+        auto all = maybe::when_all(a.get_async_result(), b.get_async_result());
+
+        b.set(result<std::string, std::string>::ok("two"));
+        REQUIRE(!all.is_ready());
+        a.set(result<int, std::string>::ok(1));
+
+        auto r = std::move(all).get();
+        REQUIRE(r);
+        REQUIRE(1 == std::get<0>(r.ok_value()));
+        REQUIRE("two" == std::get<1>(r.ok_value()));
+    }
+
+    SECTION("resolves on the first error and cancels the token")
+    {
+        maybe::cancel_token token;
+        async_promise<int, std::string> a;
+        async_promise<int, std::string> b;
+
+        auto all = maybe::when_all(token, a.get_async_result(), b.get_async_result());
+
+        b.set(result<int, std::string>::err("shard 2 failed"));
+        REQUIRE(all.is_ready());
+        REQUIRE(token.is_cancelled());
+
+        a.set(result<int, std::string>::ok(1));
+        auto r = std::move(all).get();
+        REQUIRE(!r);
+        REQUIRE("shard 2 failed" == r.err_value());
+    }
+
+    SECTION("collects a vector of results in order")
+    {
+        std::vector<async_result<int, std::string>> handles;
+        for (int i = 0; i < 5; ++i) {
+            handles.push_back(
+                async_result<int, std::string>::ready(result<int, std::string>::ok(i * i)));
+        }
+
+        auto r = maybe::when_all(std::move(handles)).get();
+        REQUIRE(r);
+        REQUIRE((std::vector<int>{0, 1, 4, 9, 16}) == r.ok_value());
+    }
+
+    SECTION("lets running tasks observe cancellation after the first error")
+    {
+        maybe::executor executor(2);
+        maybe::cancel_token token;
+
+        auto slow = executor.submit([token]() {
+            while (!token.is_cancelled()) {
+                std::this_thread::yield();
+            }
+            return result<int, std::string>::err("cancelled");
+        });
+        auto failing
+            = executor.submit([]() { return result<int, std::string>::err("shard failed"); });
+
+        auto r = maybe::when_all(token, std::move(slow), std::move(failing)).get();
+        REQUIRE(!r);
+        REQUIRE("shard failed" == r.err_value());
+    }
+}
+
+TEST_CASE("when_any")
+{
+    SECTION("resolves with the first ok value and cancels the token")
+    {
+        maybe::cancel_token token;
+        async_promise<int, std::string> a;
+        async_promise<int, std::string> b;
+
+        auto any = maybe::when_any(token, a.get_async_result(), b.get_async_result());
+
+        a.set(result<int, std::string>::err("replica 1 failed"));
+        REQUIRE(!any.is_ready());
+        b.set(result<int, std::string>::ok(2));
+        REQUIRE(token.is_cancelled());
+
+        auto r = std::move(any).get();
+        REQUIRE(r);
+        REQUIRE(2 == r.ok_value());
+    }
+
+    SECTION("collects all errors in order when every result fails")
+    {
+        async_promise<int, std::string> a;
+        async_promise<int, std::string> b;
+
+        auto any = maybe::when_any(a.get_async_result(), b.get_async_result());
+
+        b.set(result<int, std::string>::err("second"));
+        a.set(result<int, std::string>::err("first"));
+
+        auto r = std::move(any).get();
+        REQUIRE(!r);
+        REQUIRE((std::vector<std::string>{"first", "second"}) == r.err_value());
+    }
+}